@@ -17,140 +17,4430 @@
 #include <string>
 #include <fstream>
 #include <vector>
-#include <algorithm> // For find()
+#include <algorithm> // For transform and stable_sort
 #include <iomanip>   // For setw and alignment
-#include <tuple> 
 #include <cctype>    // For tolower
 #include <limits>    // For numeric_limits
+#include <string_view> // For zero-copy fields
+#include <chrono>    // For timing the ingest benchmark
+#include <cstring>   // For memchr
+#include <cstdio>    // For snprintf and rename
+#include <sys/mman.h> // For mmap
+#include <sys/stat.h> // For fstat
+#include <fcntl.h>   // For open
+#include <unistd.h>  // For close
+#include <glob.h>    // For expanding file patterns
+#include <cstdint>   // For fixed-width column types
+#include <random>    // For synthetic benchmark data
+#include <thread>    // For parallel parsing
+#include <atomic>    // For handing out work to threads
+#include <array>     // For per-thread month totals
+#include <iterator>  // For back_inserter
+#include <cmath>     // For the HyperLogLog estimate
+#include <queue>     // For the bounded top-K heap
+#include <new>       // For counting heap allocations
+#include <cstdlib>   // For malloc and free
+#include <mutex>     // For recording profile phases from several threads
+#include <condition_variable> // For handing decompressed blocks to the parser
+#include <deque>     // For the queue of decompressed blocks
+#include <memory>    // For sharing server data with client threads
+#include <charconv>  // For to_chars in report output
+#include <sys/socket.h> // For the query server
+#include <sys/un.h>  // For Unix domain socket addresses
+#if defined(__linux__)
+#include <linux/perf_event.h> // For hardware counters in profiles
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#endif
+#if defined(__x86_64__)
+#include <immintrin.h> // For SSE2 and AVX2 text matching
+#endif
 
 using namespace std;
 
-// Class to store camera data
-class CameraRecord {
+// Heap allocations made through operator new while counting is on, read by the
+// ingest benchmark and --profile to show how many allocations a load costs
+// Counting is switched on before any worker thread starts, so the flag itself needs no atomic;
+// when it is off, an allocation costs one predictable branch and no shared cache line
+bool countAllocations = false;
+atomic<uint64_t> allocationCount(0);
+atomic<uint64_t> allocationBytes(0);
+
+void* operator new(size_t bytes) {
+    if (countAllocations) {
+        allocationCount.fetch_add(1, memory_order_relaxed);
+        allocationBytes.fetch_add(bytes, memory_order_relaxed);
+    }
+    void* block = malloc(bytes == 0 ? 1 : bytes);
+    if (block == nullptr) {
+        throw bad_alloc();
+    }
+    return block;
+}
+// Kept out of line: once inlined, GCC sees free() paired with operator new and warns (-Wmismatched-new-delete)
+__attribute__((noinline)) void operator delete(void* block) noexcept { free(block); }
+__attribute__((noinline)) void operator delete(void* block, size_t) noexcept { free(block); }
+
+/**
+ * Reads a memory figure of this process from /proc/self/status
+ * @param field "VmRSS" for the current resident size or "VmHWM" for the peak since the last resetPeakMemory()
+ * @return the value in kB, or 0 where /proc is not available
+ */
+size_t processMemoryKb(const string& field) {
+    ifstream status("/proc/self/status");
+    string line;
+    while (getline(status, line)) {
+        if (line.compare(0, field.size() + 1, field + ":") == 0) {
+            return stoull(line.substr(field.size() + 1));
+        }
+    }
+    return 0;
+}
+
+// Starts a new peak resident size measurement (Linux: sets VmHWM back to VmRSS)
+void resetPeakMemory() {
+    ofstream clearRefs("/proc/self/clear_refs");
+    clearRefs << "5";
+}
+
+// Class that reads CPU cycles, instructions, cache misses and branch misses
+// of this process and the threads it starts, through perf_event_open
+// Counting is off wherever the kernel does not allow it (see /proc/sys/kernel/perf_event_paranoid)
+class HardwareCounters {
+public:
+    static const int COUNTERS = 4;
+private:
+    int fds[COUNTERS];
+public:
+    // Constructor, opens the counters
+    HardwareCounters() {
+        fill(fds, fds + COUNTERS, -1);
+#if defined(__linux__)
+        const uint64_t configs[COUNTERS] = {PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS,
+                                            PERF_COUNT_HW_CACHE_MISSES, PERF_COUNT_HW_BRANCH_MISSES};
+        for (int c = 0; c < COUNTERS; c++) {
+            perf_event_attr attr;
+            memset(&attr, 0, sizeof(attr));
+            attr.size = sizeof(attr);
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.config = configs[c];
+            attr.exclude_kernel = 1;
+            attr.exclude_hv = 1;
+            attr.inherit = 1; // Threads started later are counted too
+            fds[c] = syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+        }
+#endif
+    }
+    ~HardwareCounters() {
+        for (int fd : fds) {
+            if (fd >= 0) {
+                close(fd);
+            }
+        }
+    }
+    HardwareCounters(const HardwareCounters&) = delete;
+    HardwareCounters& operator=(const HardwareCounters&) = delete;
+
+    // Whether every counter could be opened
+    bool available() const {
+        return all_of(fds, fds + COUNTERS, [](int fd) { return fd >= 0; });
+    }
+
+    // Reads the current counts, or zeros when counting is off
+    array<uint64_t, COUNTERS> read() const {
+        array<uint64_t, COUNTERS> counts{};
+        for (int c = 0; c < COUNTERS && available(); c++) {
+            if (::read(fds[c], &counts[c], sizeof(uint64_t)) != sizeof(uint64_t)) {
+                counts[c] = 0;
+            }
+        }
+        return counts;
+    }
+};
+
+// Class that collects the time and counters of each phase of the program
+// (loading, parsing, aggregating, sorting, output, ...) when profiling is on
+// Phases are recorded by ScopedTimer and written out with dump() after each report
+class Profiler {
+public:
+    struct Phase {
+        uint64_t sequence;    // Start order, so phases print in the order they began
+        int depth;            // Nesting inside other phases of the same thread
+        string name;
+        double ms;
+        uint64_t rows, bytes; // Work done, as reported by the phase
+        uint64_t allocations, allocatedBytes;
+        array<uint64_t, HardwareCounters::COUNTERS> hardware;
+    };
+
+    // Off unless --profile is given; every timer checks this before doing anything
+    static bool enabled;
+
+private:
+    mutex lock;
+    vector<Phase> phases;
+    uint64_t nextSequence = 0;
+    HardwareCounters* counters = nullptr;
+
+public:
+    // The one profiler of the program
+    static Profiler& instance() {
+        static Profiler profiler;
+        return profiler;
+    }
+
+    // Turns profiling on and opens the hardware counters
+    void enable() {
+        enabled = true;
+        countAllocations = true;
+        if (counters == nullptr) {
+            counters = new HardwareCounters();
+        }
+    }
+
+    // Hardware counts now, zeros when they are not available
+    array<uint64_t, HardwareCounters::COUNTERS> readHardware() const {
+        return counters == nullptr ? array<uint64_t, HardwareCounters::COUNTERS>{} : counters->read();
+    }
+
+    // Number for a phase that is starting
+    uint64_t startPhase() {
+        lock_guard<mutex> guard(lock);
+        return nextSequence++;
+    }
+
+    // Records a finished phase
+    void add(const Phase& phase) {
+        lock_guard<mutex> guard(lock);
+        phases.push_back(phase);
+    }
+
+    /**
+     * Writes every phase recorded since the last dump as a table, then forgets them
+     * Allocations and hardware counts cover the whole process while a phase ran,
+     * so they include nested phases and phases running on other threads
+     * @param out Stream to write to (cerr, so report output stays clean)
+     */
+    void dump(ostream& out) {
+        lock_guard<mutex> guard(lock);
+        if (phases.empty()) {
+            return;
+        }
+        sort(phases.begin(), phases.end(), [](const Phase& a, const Phase& b) { return a.sequence < b.sequence; });
+        bool hardware = counters != nullptr && counters->available();
+        out << "-- profile --" << endl
+            << left << setw(32) << "phase" << right << setw(10) << "ms" << setw(10) << "rows" << setw(9) << "MB"
+            << setw(8) << "allocs" << setw(10) << "alloc MB";
+        if (hardware) {
+            out << setw(14) << "cycles" << setw(14) << "instructions" << setw(12) << "cache miss" << setw(12) << "branch miss";
+        }
+        out << endl;
+        for (const Phase& phase : phases) {
+            out << left << setw(32) << string(phase.depth * 2, ' ') + phase.name << right << fixed
+                << setprecision(3) << setw(10) << phase.ms << setw(10) << phase.rows
+                << setprecision(1) << setw(9) << phase.bytes / (1024.0 * 1024.0)
+                << setw(8) << phase.allocations << setw(10) << phase.allocatedBytes / (1024.0 * 1024.0);
+            if (hardware) {
+                out << setw(14) << phase.hardware[0] << setw(14) << phase.hardware[1]
+                    << setw(12) << phase.hardware[2] << setw(12) << phase.hardware[3];
+            }
+            out << endl;
+        }
+        if (!hardware) {
+            out << "(hardware counters not available)" << endl;
+        }
+        phases.clear();
+    }
+};
+
+bool Profiler::enabled = false;
+
+// Class that times the scope it lives in as one profile phase
+// When profiling is off the constructor and destructor only test one flag
+class ScopedTimer {
+private:
+    bool active;
+    Profiler::Phase phase;
+    chrono::steady_clock::time_point start;
+    static thread_local int depth; // Timers currently open on this thread
+
+public:
+    /**
+     * Starts a phase
+     * @param name Name shown in the profile
+     * @param rows Rows the phase works on, if known now (see setRows())
+     * @param bytes Bytes the phase works on, if known now (see setBytes())
+     */
+    ScopedTimer(const char* name, uint64_t rows = 0, uint64_t bytes = 0) : active(Profiler::enabled) {
+        if (!active) {
+            return;
+        }
+        Profiler& profiler = Profiler::instance();
+        phase.sequence = profiler.startPhase();
+        phase.depth = depth++;
+        phase.name = name;
+        phase.rows = rows;
+        phase.bytes = bytes;
+        phase.allocations = allocationCount;
+        phase.allocatedBytes = allocationBytes;
+        phase.hardware = profiler.readHardware();
+        start = chrono::steady_clock::now();
+    }
+
+    ~ScopedTimer() {
+        if (!active) {
+            return;
+        }
+        Profiler& profiler = Profiler::instance();
+        phase.ms = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+        phase.allocations = allocationCount - phase.allocations;
+        phase.allocatedBytes = allocationBytes - phase.allocatedBytes;
+        array<uint64_t, HardwareCounters::COUNTERS> hardware = profiler.readHardware();
+        for (int c = 0; c < HardwareCounters::COUNTERS; c++) {
+            phase.hardware[c] = hardware[c] - phase.hardware[c];
+        }
+        depth--;
+        profiler.add(phase);
+    }
+    ScopedTimer(const ScopedTimer&) = delete;
+    ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+    // Sets the work counters once they are known
+    void setRows(uint64_t rows) {
+        if (active) {
+            phase.rows = rows;
+        }
+    }
+    void setBytes(uint64_t bytes) {
+        if (active) {
+            phase.bytes = bytes;
+        }
+    }
+};
+
+thread_local int ScopedTimer::depth = 0;
+
+// Writes the phases recorded since the last call to cerr when profiling is on
+void dumpProfile() {
+    if (!Profiler::enabled) {
+        return;
+    }
+    cout.flush(); // Keep the report above its profile
+    Profiler::instance().dump(cerr);
+}
+
+// Class that maps a whole file into memory so records can point straight into it
+class MappedFile {
 private:
-    string intersection;  // Street intersection where camera is located
-    string address;      // Full address of the camera
-    string cameraNumber; // Unique identifier for each camera
-    string date;        // Date of the violation record
-    int violations;     // Number of violations recorded
-    string neighborhood; // Neighborhood where camera is located
+    const char* data; // Start of the mapped bytes (nullptr when nothing is mapped)
+    size_t size;      // Number of mapped bytes
 public:
     // Constructor
-    CameraRecord(string inter, string add, string camNum, string d, int vio, string neigh) {
-        intersection = inter;
-        address = add;
-        cameraNumber = camNum;
-        date = d;
-        violations = vio;
-        neighborhood = neigh;
+    MappedFile() : data(nullptr), size(0) {}
+    ~MappedFile() { close(); }
+    // The mapping is owned, so copying is not allowed
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    /**
+     * Maps a file read-only into memory
+     * @param fileName The name of the file to map
+     * @return true if the file was opened (an empty file maps to zero bytes)
+     */
+    bool open(const string& fileName) {
+        close();
+        int fd = ::open(fileName.c_str(), O_RDONLY);
+        if (fd < 0) {
+            return false;
+        }
+        struct stat info;
+        if (fstat(fd, &info) != 0) {
+            ::close(fd);
+            return false;
+        }
+        size = info.st_size;
+        if (size > 0) {
+            void* mapped = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (mapped == MAP_FAILED) {
+                ::close(fd);
+                size = 0;
+                return false;
+            }
+            madvise(mapped, size, MADV_SEQUENTIAL); // We read front to back once
+            data = static_cast<const char*>(mapped);
+        }
+        ::close(fd); // The mapping stays valid after the descriptor is closed
+        return true;
+    }
+
+    // Unmaps the file if one is mapped
+    void close() {
+        if (data != nullptr) {
+            munmap(const_cast<char*>(data), size);
+        }
+        data = nullptr;
+        size = 0;
     }
+
     // Getters
-    string getInter() const { return intersection; }
-    string getAdd() const { return address; }
-    string getCamNum() const { return cameraNumber; }
-    string getDate() const { return date; }
-    int getVio() const { return violations; }
-    string getNeigh() const { return neighborhood; }
+    const char* begin() const { return data; }
+    const char* end() const { return data + size; }
+    size_t getSize() const { return size; }
 };
 
-// Function prototypes
-vector<CameraRecord> readFile(string fileName);
-void dataOverview(const vector<CameraRecord>& cameraRecords);
-void resultsByNeighborhood(const vector<CameraRecord>& cameraRecords);
-void displayChartByMonth(const vector<CameraRecord>& cameraRecords);
-string getMonth(int monthNumber);
-void searchByCamera(const vector<CameraRecord>& cameraRecords);
+// Header at the start of a binary snapshot file
+// The checksum covers every byte after the header
+struct SnapshotHeader {
+    char magic[8];       // "CAMSNAP" followed by a zero byte
+    uint32_t version;    // Layout version, snapshots of another version are ignored
+    uint32_t headerBytes; // sizeof(SnapshotHeader) of the writer
+    uint64_t sourceSize; // Size of the source file the snapshot was built from
+    int64_t sourceTime;  // Modification time of the source file, whole seconds
+    int64_t sourceNanos; // Nanoseconds of the modification time, so rewrites within one second are noticed
+    uint64_t sourceInode; // Inode of the source file, so a file moved over it is noticed
+    uint64_t checksum;   // Checksum of the payload, see SnapshotWriter::hashWords()
 
+    // Records which version of a source file the snapshot describes
+    void setSource(const struct stat& source) {
+        sourceSize = source.st_size;
+        sourceTime = source.st_mtim.tv_sec;
+        sourceNanos = source.st_mtim.tv_nsec;
+        sourceInode = source.st_ino;
+    }
 
-int main() {
-    int choice;
-    string fileName;
+    // Whether the snapshot was built from this version of the source file
+    bool matchesSource(const struct stat& source) const {
+        return sourceSize == (uint64_t)source.st_size && sourceTime == source.st_mtim.tv_sec
+               && sourceNanos == source.st_mtim.tv_nsec && sourceInode == (uint64_t)source.st_ino;
+    }
+};
 
-    // Get input file name from user
-    cout << "Enter file to use: " << endl;
-    cin >> fileName;
-    vector<CameraRecord> cameraRecords = readFile(fileName); // Read data from file
+const char snapshotMagic[8] = {'C', 'A', 'M', 'S', 'N', 'A', 'P', 0};
+const uint32_t snapshotVersion = 7;
 
-    // Main menu loop
-    do {
-        cout << "\nSelect a menu option:" << endl;
-        cout << "  1. Data overview" << endl;
-        cout << "  2. Results by neighborhood" << endl;
-        cout << "  3. Chart by month" << endl;
-        cout << "  4. Search for cameras" << endl;
-        cout << "  5. Exit" << endl;
-        cout << "Your choice: ";
-        
-        // Input validation to handle non-numeric input
-        if (!(cin >> choice)) {
-            cin.clear();  // Clear the error flags
-            cin.ignore(numeric_limits<streamsize>::max(), '\n');  // Clear the input buffer
-            cout << "Invalid choice. Please try again." << endl;
-            continue;
+// Class that writes a snapshot as a series of 8-byte aligned sections
+class SnapshotWriter {
+private:
+    ofstream fileOut;
+    SnapshotHeader header;
+    uint64_t checksum;
+
+public:
+    /**
+     * Mixes whole 64-bit words into a running checksum
+     * @param checksum Running checksum, updated in place
+     * @param data Start of the words
+     * @param words Number of 64-bit words
+     */
+    static void hashWords(uint64_t& checksum, const char* data, size_t words) {
+        for (size_t i = 0; i < words; i++) {
+            uint64_t word;
+            memcpy(&word, data + i * 8, 8);
+            checksum = ((checksum ^ word) * 0x9e3779b97f4a7c15ull);
+            checksum ^= checksum >> 29;
         }
- 
-        // Process user choice
-        switch(choice){
-            case 1:
-                dataOverview(cameraRecords);
-                break;
-            case 2:
-                resultsByNeighborhood(cameraRecords);
-                break;
-            case 3:
-                displayChartByMonth(cameraRecords);
-                break;
-            case 4:
-                searchByCamera(cameraRecords);
-                break;
-            case 5:
-                break;
-            default:
-                cout << "Invalid choice. Please try again." << endl;
+    }
+
+    /**
+     * Starts a snapshot file
+     * @param fileName File to create
+     * @param source stat() of the source the snapshot describes
+     * @return true if the file could be created
+     */
+    bool open(const string& fileName, const struct stat& source) {
+        fileOut.open(fileName, ios::binary | ios::trunc);
+        memcpy(header.magic, snapshotMagic, 8);
+        header.version = snapshotVersion;
+        header.headerBytes = sizeof(SnapshotHeader);
+        header.setSource(source);
+        header.checksum = 0;
+        checksum = 0;
+        fileOut.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        return fileOut.good();
+    }
+
+    // Writes raw bytes, padded with zeros to a multiple of 8
+    void section(const void* data, size_t bytes) {
+        const char* start = static_cast<const char*>(data);
+        size_t whole = bytes / 8;
+        hashWords(checksum, start, whole);
+        char tail[8] = {0};
+        memcpy(tail, start + whole * 8, bytes % 8);
+        if (bytes % 8 != 0) {
+            hashWords(checksum, tail, 1);
         }
-    } while (choice != 5);
+        const char padding[8] = {0};
+        fileOut.write(start, bytes);
+        fileOut.write(padding, (8 - bytes % 8) % 8);
+    }
 
-    return 0;
+    // Writes a vector as its element count followed by its elements
+    template <typename T>
+    void values(const vector<T>& column) {
+        uint64_t count = column.size();
+        section(&count, sizeof(count));
+        section(column.data(), count * sizeof(T));
+    }
+
+    /**
+     * Stores the checksum in the header and closes the file
+     * @return true if every write succeeded
+     */
+    bool finish() {
+        header.checksum = checksum;
+        fileOut.seekp(0);
+        fileOut.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        fileOut.close();
+        return !fileOut.fail();
+    }
+};
+
+// Class that reads the sections of a mapped snapshot file back in order
+class SnapshotReader {
+private:
+    MappedFile mappedFile;
+    const char* pos; // Next unread section
+
+public:
+    // Constructor
+    SnapshotReader() : pos(nullptr) {}
+
+    /**
+     * Maps a snapshot and checks that it is complete and up to date
+     * @param fileName The snapshot file
+     * @param source stat() of the source it must describe
+     * @return true if the header matches and the checksum is correct
+     */
+    bool open(const string& fileName, const struct stat& source) {
+        if (!mappedFile.open(fileName) || mappedFile.getSize() < sizeof(SnapshotHeader)
+            || (mappedFile.getSize() - sizeof(SnapshotHeader)) % 8 != 0) {
+            return false;
+        }
+        SnapshotHeader header;
+        memcpy(&header, mappedFile.begin(), sizeof(header));
+        if (memcmp(header.magic, snapshotMagic, 8) != 0 || header.version != snapshotVersion
+            || header.headerBytes != sizeof(SnapshotHeader)
+            || !header.matchesSource(source)) {
+            return false;
+        }
+        pos = mappedFile.begin() + sizeof(SnapshotHeader);
+        uint64_t checksum = 0;
+        SnapshotWriter::hashWords(checksum, pos, (mappedFile.end() - pos) / 8);
+        return checksum == header.checksum;
+    }
+
+    /**
+     * Takes the next section
+     * @param bytes Size of the section without padding
+     * @return start of the section, or nullptr if the file is too short
+     */
+    const char* section(size_t bytes) {
+        size_t padded = (bytes + 7) / 8 * 8;
+        if (pos == nullptr || padded > (size_t)(mappedFile.end() - pos)) {
+            pos = nullptr; // Every later read fails too
+            return nullptr;
+        }
+        const char* start = pos;
+        pos += padded;
+        return start;
+    }
+
+    // Reads a vector written by SnapshotWriter::values()
+    template <typename T>
+    bool values(vector<T>& column) {
+        const char* countData = section(sizeof(uint64_t));
+        if (countData == nullptr) {
+            return false;
+        }
+        uint64_t count;
+        memcpy(&count, countData, sizeof(count));
+        if (count > (uint64_t)(mappedFile.end() - pos) / sizeof(T)) {
+            pos = nullptr;
+            return false;
+        }
+        const char* data = section(count * sizeof(T));
+        column.resize(count);
+        memcpy(column.data(), data, count * sizeof(T));
+        return true;
+    }
+};
+
+// Class that stores each distinct string once and hands out dense integer ids
+// Ids are given in order of first appearance, so id order matches file order
+class StringPool {
+private:
+    string bytes;             // All distinct strings stored back to back
+    vector<uint32_t> offsets; // String id starts at offsets[id] and ends at offsets[id + 1]
+    vector<int32_t> slots;    // Open-addressing hash table of ids, -1 marks an empty slot
+
+    // Finds the slot holding value, or the empty slot where it belongs
+    size_t findSlot(string_view value) const {
+        size_t mask = slots.size() - 1;
+        size_t slot = hash(value) & mask;
+        while (slots[slot] != -1 && get(slots[slot]) != value) {
+            slot = (slot + 1) & mask; // Linear probing
+        }
+        return slot;
+    }
+
+    // Doubles the hash table and re-inserts every id
+    void grow() {
+        vector<int32_t> oldSlots(slots.size() * 2, -1);
+        slots.swap(oldSlots);
+        for (int32_t id : oldSlots) {
+            if (id != -1) {
+                slots[findSlot(get(id))] = id;
+            }
+        }
+    }
+public:
+    // FNV-1a hash of a string, also used by CameraSketches::hashText()
+    static uint64_t hash(string_view value) {
+        uint64_t h = 14695981039346656037ull;
+        for (unsigned char c : value) {
+            h = (h ^ c) * 1099511628211ull;
+        }
+        return h;
+    }
+
+    // Constructor
+    StringPool() : offsets(1, 0), slots(16, -1) {}
+
+    /**
+     * Finds the id of a string, adding it to the pool if it is new
+     * @param value The string to intern
+     * @return the dense id of value
+     */
+    int32_t intern(string_view value) {
+        size_t slot = findSlot(value);
+        if (slots[slot] != -1) {
+            return slots[slot];
+        }
+        int32_t id = size();
+        bytes.append(value);
+        offsets.push_back(bytes.size());
+        slots[slot] = id;
+        // Keep the table at most half full so probe chains stay short
+        if ((size_t)size() * 2 > slots.size()) {
+            grow();
+        }
+        return id;
+    }
+
+    /**
+     * Looks up a string without adding it
+     * @return the id of value, or -1 if it was never interned
+     */
+    int32_t find(string_view value) const {
+        return slots[findSlot(value)];
+    }
+
+    // Text of an id; the view is valid until the next intern()
+    string_view get(int32_t id) const {
+        return string_view(bytes.data() + offsets[id], offsets[id + 1] - offsets[id]);
+    }
+
+    // Number of distinct strings
+    int32_t size() const { return offsets.size() - 1; }
+
+    // Bytes held by the pool
+    size_t memoryUsage() const {
+        return bytes.capacity() + offsets.capacity() * sizeof(uint32_t) + slots.capacity() * sizeof(int32_t);
+    }
+
+    // Writes the strings to a snapshot
+    void save(SnapshotWriter& writer) const {
+        writer.values(offsets);
+        vector<char> text(bytes.begin(), bytes.end());
+        writer.values(text);
+    }
+
+    /**
+     * Replaces the pool with strings saved by save() and rebuilds the hash table
+     * @return true if the saved strings were consistent
+     */
+    bool load(SnapshotReader& reader) {
+        vector<char> text;
+        if (!reader.values(offsets) || !reader.values(text) || offsets.empty() || offsets[0] != 0) {
+            return false;
+        }
+        for (size_t id = 1; id < offsets.size(); id++) {
+            if (offsets[id] < offsets[id - 1] || offsets[id] > text.size()) {
+                return false;
+            }
+        }
+        bytes.assign(text.begin(), text.end());
+        size_t capacity = 16;
+        while (capacity < offsets.size() * 2) {
+            capacity *= 2;
+        }
+        slots.assign(capacity, -1);
+        for (int32_t id = 0; id < size(); id++) {
+            slots[findSlot(get(id))] = id;
+        }
+        return true;
+    }
+};
+
+/**
+ * Runs task(0) ... task(tasks - 1) on a small pool of threads
+ * Threads take the next unstarted task from a shared counter, so uneven tasks balance out
+ * @param tasks Number of tasks
+ * @param threads Number of threads, the calling thread counts as one of them
+ * @param task Function called once with each task number
+ * @post every task has finished
+ */
+template <typename Task>
+void parallelFor(size_t tasks, int threads, const Task& task) {
+    atomic<size_t> nextTask(0);
+    auto worker = [&]() {
+        for (size_t t = nextTask++; t < tasks; t = nextTask++) {
+            task(t);
+        }
+    };
+
+    vector<thread> pool;
+    for (int i = 1; i < threads && (size_t)i < tasks; i++) {
+        pool.emplace_back(worker);
+    }
+    worker();
+    for (thread& t : pool) {
+        t.join();
+    }
+}
+
+/**
+ * Picks how many row ranges a parallel scan should use
+ * Ranges hold at least 64k rows so small tables are scanned by one thread
+ * @param rows Number of rows to scan
+ * @param threads Number of threads available
+ * @return number of ranges, at least 1; range c covers rows [rows * c / ranges, rows * (c + 1) / ranges)
+ */
+size_t scanRanges(size_t rows, int threads) {
+    const size_t minRangeRows = 1 << 16;
+    return max((size_t)1, min((size_t)threads * 4, rows / minRangeRows));
+}
+
+/**
+ * Number of threads to use when none was asked for
+ * @return the number of hardware threads, at least 1
+ */
+int defaultThreads() {
+    unsigned int cores = thread::hardware_concurrency();
+    return cores == 0 ? 1 : cores;
+}
+
+// Class that maps 64-bit keys to non-negative int32 values with open addressing
+// Used to group and de-duplicate rows by key in a single pass
+class HashMap {
+private:
+    vector<uint64_t> keys;  // Key stored in each slot
+    vector<int32_t> values; // Value stored in each slot, -1 marks an empty slot
+    size_t count;           // Number of keys stored
+
+    // Finds the slot holding key, or the empty slot where it belongs
+    size_t findSlot(uint64_t key) const {
+        size_t mask = keys.size() - 1;
+        size_t slot = mix(key) & mask;
+        while (values[slot] != -1 && keys[slot] != key) {
+            slot = (slot + 1) & mask; // Linear probing
+        }
+        return slot;
+    }
+
+    // Doubles the table and re-inserts every key
+    void grow() {
+        vector<uint64_t> oldKeys(keys.size() * 2);
+        vector<int32_t> oldValues(values.size() * 2, -1);
+        keys.swap(oldKeys);
+        values.swap(oldValues);
+        for (size_t i = 0; i < oldKeys.size(); i++) {
+            if (oldValues[i] != -1) {
+                size_t slot = findSlot(oldKeys[i]);
+                keys[slot] = oldKeys[i];
+                values[slot] = oldValues[i];
+            }
+        }
+    }
+public:
+    // Spreads the bits of a key so dense ids do not cluster (splitmix64 finalizer), also used by CameraSketches::hashText()
+    static uint64_t mix(uint64_t key) {
+        key = (key ^ (key >> 30)) * 0xbf58476d1ce4e5b9ull;
+        key = (key ^ (key >> 27)) * 0x94d049bb133111ebull;
+        return key ^ (key >> 31);
+    }
+
+    // Constructor, sized so that expected keys fit without growing
+    HashMap(size_t expected = 8) : count(0) {
+        size_t capacity = 16;
+        while (capacity < expected * 2) {
+            capacity *= 2;
+        }
+        keys.resize(capacity);
+        values.assign(capacity, -1);
+    }
+
+    /**
+     * Finds the value of a key, inserting the key with the given value if it is new
+     * @param key The key to look up
+     * @param value The value to store when key is new, must not be negative
+     * @return the value stored for key (equal to value when key was just inserted)
+     */
+    int32_t findOrInsert(uint64_t key, int32_t value) {
+        size_t slot = findSlot(key);
+        if (values[slot] != -1) {
+            return values[slot];
+        }
+        keys[slot] = key;
+        values[slot] = value;
+        // Keep the table at most half full so probe chains stay short
+        if (++count * 2 > keys.size()) {
+            grow();
+        }
+        return value;
+    }
+
+    /**
+     * Adds a key when it is not already present, for use as a set
+     * @return true if key was new
+     */
+    bool insert(uint64_t key) {
+        size_t before = count;
+        findOrInsert(key, 0);
+        return count != before;
+    }
+
+    // Value of a key, or -1 if the key is not present
+    int32_t find(uint64_t key) const { return values[findSlot(key)]; }
+
+    // Calls visit(key, value) for every key, in slot order
+    template <typename Visitor>
+    void forEach(const Visitor& visit) const {
+        for (size_t i = 0; i < keys.size(); i++) {
+            if (values[i] != -1) {
+                visit(keys[i], values[i]);
+            }
+        }
+    }
+
+    // Number of keys stored
+    size_t size() const { return count; }
+};
+
+// Class that groups rows by key and, in the same pass, sums a value and
+// counts the distinct values of a second column for each group
+// Groups are numbered in order of first appearance
+class GroupAggregator {
+private:
+    HashMap groupIndex;          // Group key to group number
+    HashMap distinctPairs;       // (group number, distinct value) pairs already counted
+    vector<uint64_t> groupKeys;  // Key of each group
+    vector<int64_t> sums;        // Sum of values in each group
+    vector<int64_t> rowCounts;   // Number of rows in each group
+    vector<int32_t> distinctCounts; // Number of distinct values in each group
+public:
+    /**
+     * Adds one row to its group
+     * @param key The group the row belongs to
+     * @param value The amount added to the group's sum
+     * @param distinctValue The value counted once per group
+     */
+    void add(uint64_t key, int64_t value, uint32_t distinctValue) {
+        int32_t group = groupIndex.findOrInsert(key, groupKeys.size());
+        if (group == (int32_t)groupKeys.size()) {
+            groupKeys.push_back(key);
+            sums.push_back(0);
+            rowCounts.push_back(0);
+            distinctCounts.push_back(0);
+        }
+        sums[group] += value;
+        rowCounts[group]++;
+        if (distinctPairs.insert((uint64_t)group << 32 | distinctValue)) {
+            distinctCounts[group]++;
+        }
+    }
+
+    /**
+     * Combines the groups of an aggregator that saw a later range of rows
+     * @pre other covers rows after the ones in this aggregator, so group numbers stay in first-appearance order
+     */
+    void merge(const GroupAggregator& other) {
+        // Map each of other's group numbers to a group number here
+        vector<int32_t> groupMap(other.size());
+        for (int32_t otherGroup = 0; otherGroup < other.size(); otherGroup++) {
+            int32_t group = groupIndex.findOrInsert(other.groupKeys[otherGroup], groupKeys.size());
+            if (group == (int32_t)groupKeys.size()) {
+                groupKeys.push_back(other.groupKeys[otherGroup]);
+                sums.push_back(0);
+                rowCounts.push_back(0);
+                distinctCounts.push_back(0);
+            }
+            sums[group] += other.sums[otherGroup];
+            rowCounts[group] += other.rowCounts[otherGroup];
+            groupMap[otherGroup] = group;
+        }
+        // Distinct values seen on both sides must only be counted once
+        other.distinctPairs.forEach([&](uint64_t pair, int32_t) {
+            int32_t group = groupMap[pair >> 32];
+            if (distinctPairs.insert((uint64_t)group << 32 | (uint32_t)pair)) {
+                distinctCounts[group]++;
+            }
+        });
+    }
+
+    /**
+     * Adds a group whose totals were worked out elsewhere, such as in a RollupCube
+     * @pre key is not in the aggregator yet and no rows are added to it later
+     */
+    void addTotals(uint64_t key, int64_t sum, int64_t rows, int32_t distinct) {
+        groupIndex.findOrInsert(key, groupKeys.size());
+        groupKeys.push_back(key);
+        sums.push_back(sum);
+        rowCounts.push_back(rows);
+        distinctCounts.push_back(distinct);
+    }
+
+    // Number of groups
+    int32_t size() const { return groupKeys.size(); }
+
+    // Getters for one group
+    uint64_t getKey(int32_t group) const { return groupKeys[group]; }
+    int64_t getSum(int32_t group) const { return sums[group]; }
+    int64_t getRows(int32_t group) const { return rowCounts[group]; }
+    int32_t getDistinct(int32_t group) const { return distinctCounts[group]; }
+};
+
+/**
+ * Packs a calendar date into one integer that sorts in date order
+ * @param year Four digit year
+ * @param month Month number (1-12)
+ * @param day Day of the month (1-31)
+ * @return the date as year << 9 | month << 5 | day
+ */
+constexpr uint32_t packDate(int year, int month, int day) {
+    return (uint32_t)year << 9 | (uint32_t)month << 5 | (uint32_t)day;
+}
+
+// Parts of a packed date; dateYearMonth() is year * 16 + month, so it orders and buckets by month
+int dateYear(uint32_t date) { return date >> 9; }
+int dateMonth(uint32_t date) { return date >> 5 & 15; }
+int dateDay(uint32_t date) { return date & 31; }
+uint32_t dateYearMonth(uint32_t date) { return date >> 5; }
+
+/**
+ * Parses a date in year-month-day format, where month and day may be one or two digits
+ * The field widths are worked out from where the hyphens are and the digits are
+ * combined with arithmetic instead of a loop, so the only branches are the length checks
+ * and the final check. Days past the end of the month (such as "2023-2-29") are invalid
+ * @param date Date text such as "2023-9-4"
+ * @return the packed date (see packDate()), or 0 if the text is not a valid date
+ */
+constexpr uint32_t parseDate(string_view date) {
+    // Shortest form is "YYYY-M-D" and longest is "YYYY-MM-DD"
+    if (date.size() < 8 || date.size() > 10) {
+        return 0;
+    }
+    auto digit = [date](size_t i) -> unsigned { return (unsigned char)date[i] - '0'; };
+    unsigned y0 = digit(0), y1 = digit(1), y2 = digit(2), y3 = digit(3);
+    unsigned year = y0 * 1000 + y1 * 100 + y2 * 10 + y3;
+
+    // The month has two digits when position 6 is not the second hyphen
+    unsigned twoDigitMonth = date[6] != '-';
+    unsigned m0 = digit(5), m1 = digit(6) * twoDigitMonth;
+    unsigned month = m0 * (1 + 9 * twoDigitMonth) + m1;
+
+    // The day is whatever follows the second hyphen, checked before it is read ("2023-12-" has none)
+    size_t dayStart = 7 + twoDigitMonth;
+    size_t dayLength = date.size() - dayStart;
+    if (dayLength != 1 && dayLength != 2) {
+        return 0;
+    }
+    unsigned twoDigitDay = dayLength == 2;
+    unsigned d0 = digit(dayStart), d1 = digit(dayStart + twoDigitDay) * twoDigitDay;
+    unsigned day = d0 * (1 + 9 * twoDigitDay) + d1;
+
+    // February has 29 days in leap years, and the other months alternate 31 and 30 with
+    // the pattern flipping after July
+    unsigned leapYear = year % 4 == 0 && (year % 100 != 0 || year % 400 == 0);
+    unsigned monthDays = month == 2 ? 28 + leapYear : 30 + ((month + (month >> 3)) & 1);
+
+    // Unsigned digit values above 9 mean the character was not a digit
+    bool valid = max({y0, y1, y2, y3, m0, m1, d0, d1}) <= 9
+                 && date[4] == '-' && date[dayStart - 1] == '-'
+                 && month >= 1 && month <= 12 && day >= 1 && day <= monthDays;
+    return valid ? packDate(year, month, day) : 0;
+}
+
+// Checked when compiling: years whose digits are above 1 (2019, 2028) parse, and dates
+// cut short or past the end of their month do not
+static_assert(parseDate("2019-12-31") == packDate(2019, 12, 31) && parseDate("2028-2-29") == packDate(2028, 2, 29)
+              && parseDate("2019-7-4") == packDate(2019, 7, 4) && parseDate("2000-02-29") == packDate(2000, 2, 29),
+              "parseDate rejects a valid date");
+static_assert(parseDate("2023-12-") == 0 && parseDate("2023-02-31") == 0 && parseDate("2019-2-29") == 0
+              && parseDate("1900-2-29") == 0 && parseDate("2023-4-31") == 0 && parseDate("2023-13-1") == 0,
+              "parseDate accepts an invalid date");
+
+// Class to store camera data column by column
+// Each report only reads the one or two columns it needs, and the repeated
+// text fields are stored once in a dictionary and referenced by id
+class CameraTable {
+private:
+    vector<int32_t> violations;      // Number of violations recorded
+    vector<uint32_t> dates;          // Date of the violation record, packed by packDate() (0 if unreadable)
+    vector<int32_t> cameraIds;       // Id of the camera's number in cameraDict
+    vector<int32_t> intersectionIds; // Id of the street intersection in intersectionDict
+    vector<int32_t> addressIds;      // Id of the full address in addressDict
+    vector<int32_t> neighborhoodIds; // Id of the neighborhood in neighborhoodDict
+    vector<int32_t> regionIds;       // Id of the region (source file) in regionDict
+
+    // Dictionaries between id and text, only turned back into text when printing
+    StringPool cameraDict;
+    StringPool intersectionDict;
+    StringPool addressDict;
+    StringPool neighborhoodDict;
+    StringPool regionDict;
+    int32_t currentRegion; // Region given to rows added by addRecord()
+public:
+    // Constructor, rows belong to the unnamed region "" until setRegion() is called
+    CameraTable() { setRegion(""); }
+
+    // Sets the region, usually the source file's name, of the rows added after this call
+    void setRegion(string_view region) {
+        currentRegion = regionDict.intern(region);
+    }
+
+    // Reserves room in every column for a number of rows
+    void reserve(size_t rows) {
+        violations.reserve(rows);
+        dates.reserve(rows);
+        cameraIds.reserve(rows);
+        intersectionIds.reserve(rows);
+        addressIds.reserve(rows);
+        neighborhoodIds.reserve(rows);
+        regionIds.reserve(rows);
+    }
+
+    /**
+     * Appends one row to every column
+     * @post the table holds one more record
+     */
+    void addRecord(string_view inter, string_view add, string_view camNum, uint32_t date, int vio, string_view neigh) {
+        intersectionIds.push_back(intersectionDict.intern(inter));
+        addressIds.push_back(addressDict.intern(add));
+        cameraIds.push_back(cameraDict.intern(camNum));
+        dates.push_back(date);
+        violations.push_back(vio);
+        neighborhoodIds.push_back(neighborhoodDict.intern(neigh));
+        regionIds.push_back(currentRegion);
+    }
+
+    /**
+     * Appends several tables, in order, to the end of this one
+     * Dictionary ids of each part are remapped into this table's dictionaries,
+     * then the parts' columns are copied in parallel
+     * @param parts Tables to append, usually chunks of one file parsed on separate threads
+     * @param threads Number of threads used for copying
+     * @post rows and first-appearance id order are the same as if the parts had been read one after another
+     */
+    void append(const vector<CameraTable>& parts, int threads) {
+        // Remap each part's dictionary ids, one part after another to keep id order stable
+        vector<vector<int32_t>> cameraMaps(parts.size()), interMaps(parts.size()),
+                                addMaps(parts.size()), neighMaps(parts.size()), regionMaps(parts.size());
+        vector<size_t> firstRow(parts.size());
+        size_t rows = size();
+        for (size_t p = 0; p < parts.size(); p++) {
+            const CameraTable& part = parts[p];
+            for (int32_t id = 0; id < part.cameraDict.size(); id++) {
+                cameraMaps[p].push_back(cameraDict.intern(part.cameraDict.get(id)));
+            }
+            for (int32_t id = 0; id < part.intersectionDict.size(); id++) {
+                interMaps[p].push_back(intersectionDict.intern(part.intersectionDict.get(id)));
+            }
+            for (int32_t id = 0; id < part.addressDict.size(); id++) {
+                addMaps[p].push_back(addressDict.intern(part.addressDict.get(id)));
+            }
+            for (int32_t id = 0; id < part.neighborhoodDict.size(); id++) {
+                neighMaps[p].push_back(neighborhoodDict.intern(part.neighborhoodDict.get(id)));
+            }
+            for (int32_t id = 0; id < part.regionDict.size(); id++) {
+                regionMaps[p].push_back(regionDict.intern(part.regionDict.get(id)));
+            }
+            firstRow[p] = rows;
+            rows += part.size();
+        }
+
+        violations.resize(rows);
+        dates.resize(rows);
+        cameraIds.resize(rows);
+        intersectionIds.resize(rows);
+        addressIds.resize(rows);
+        neighborhoodIds.resize(rows);
+        regionIds.resize(rows);
+
+        // Every part writes its own slice of the columns
+        parallelFor(parts.size(), threads, [&](size_t p) {
+            const CameraTable& part = parts[p];
+            size_t row = firstRow[p];
+            for (size_t i = 0; i < part.size(); i++, row++) {
+                violations[row] = part.violations[i];
+                dates[row] = part.dates[i];
+                cameraIds[row] = cameraMaps[p][part.cameraIds[i]];
+                intersectionIds[row] = interMaps[p][part.intersectionIds[i]];
+                addressIds[row] = addMaps[p][part.addressIds[i]];
+                neighborhoodIds[row] = neighMaps[p][part.neighborhoodIds[i]];
+                regionIds[row] = regionMaps[p][part.regionIds[i]];
+            }
+        });
+    }
+
+    // Number of records in the table
+    size_t size() const { return violations.size(); }
+
+    // Column getters
+    const vector<int32_t>& getVioColumn() const { return violations; }
+    const vector<uint32_t>& getDateColumn() const { return dates; }
+    const vector<int32_t>& getCamColumn() const { return cameraIds; }
+    const vector<int32_t>& getInterColumn() const { return intersectionIds; }
+    const vector<int32_t>& getAddColumn() const { return addressIds; }
+    const vector<int32_t>& getNeighColumn() const { return neighborhoodIds; }
+    const vector<int32_t>& getRegionColumn() const { return regionIds; }
+
+    // Dictionary getters from id to text
+    string_view getCamNum(int32_t id) const { return cameraDict.get(id); }
+    string_view getInter(int32_t id) const { return intersectionDict.get(id); }
+    string_view getAdd(int32_t id) const { return addressDict.get(id); }
+    string_view getNeigh(int32_t id) const { return neighborhoodDict.get(id); }
+    string_view getRegion(int32_t id) const { return regionDict.get(id); }
+
+    // Number of distinct values in each dictionary
+    int32_t getCamCount() const { return cameraDict.size(); }
+    int32_t getInterCount() const { return intersectionDict.size(); }
+    int32_t getNeighCount() const { return neighborhoodDict.size(); }
+    int32_t getRegionCount() const { return regionDict.size(); }
+
+    // Writes the dictionaries and every column to a snapshot
+    void save(SnapshotWriter& writer) const {
+        cameraDict.save(writer);
+        intersectionDict.save(writer);
+        addressDict.save(writer);
+        neighborhoodDict.save(writer);
+        regionDict.save(writer);
+        writer.values(violations);
+        writer.values(dates);
+        writer.values(cameraIds);
+        writer.values(intersectionIds);
+        writer.values(addressIds);
+        writer.values(neighborhoodIds);
+        writer.values(regionIds);
+    }
+
+    /**
+     * Replaces the table with one written by save()
+     * @return true if the snapshot was complete and every id is inside its dictionary
+     */
+    bool load(SnapshotReader& reader) {
+        if (!cameraDict.load(reader) || !intersectionDict.load(reader)
+            || !addressDict.load(reader) || !neighborhoodDict.load(reader) || !regionDict.load(reader)
+            || !reader.values(violations) || !reader.values(dates) || !reader.values(cameraIds)
+            || !reader.values(intersectionIds) || !reader.values(addressIds) || !reader.values(neighborhoodIds)
+            || !reader.values(regionIds)) {
+            return false;
+        }
+        size_t rows = violations.size();
+        if (dates.size() != rows || cameraIds.size() != rows || intersectionIds.size() != rows
+            || addressIds.size() != rows || neighborhoodIds.size() != rows || regionIds.size() != rows) {
+            return false;
+        }
+        for (size_t i = 0; i < rows; i++) {
+            if ((uint32_t)cameraIds[i] >= (uint32_t)cameraDict.size()
+                || (uint32_t)intersectionIds[i] >= (uint32_t)intersectionDict.size()
+                || (uint32_t)addressIds[i] >= (uint32_t)addressDict.size()
+                || (uint32_t)neighborhoodIds[i] >= (uint32_t)neighborhoodDict.size()
+                || (uint32_t)regionIds[i] >= (uint32_t)regionDict.size()) {
+                return false;
+            }
+        }
+        currentRegion = regionDict.size() > 0 ? 0 : regionDict.intern("");
+        return true;
+    }
+
+    // Bytes held by the columns and dictionaries
+    size_t memoryUsage() const {
+        return (violations.capacity() + cameraIds.capacity() + intersectionIds.capacity()
+                + addressIds.capacity() + neighborhoodIds.capacity() + regionIds.capacity()) * sizeof(int32_t)
+            + dates.capacity() * sizeof(uint32_t)
+            + cameraDict.memoryUsage() + intersectionDict.memoryUsage()
+            + addressDict.memoryUsage() + neighborhoodDict.memoryUsage() + regionDict.memoryUsage();
+    }
+};
+
+// Class that gathers every overview statistic in a single pass over the table
+// Statistics of separate row ranges can be merged, so new summary reports can
+// reuse it on any slice of the data
+class OverviewStats {
+private:
+    int64_t records;         // Number of rows scanned
+    int64_t totalViolations; // Sum of the violations column
+    int32_t maxViolations;   // Largest violations value seen
+    size_t maxRow;           // First row holding maxViolations
+    vector<uint64_t> seenCameras; // Bit per camera id that appeared
+public:
+    // Constructor
+    OverviewStats() : records(0), totalViolations(0), maxViolations(0), maxRow(0) {}
+
+    /**
+     * Adds rows [begin, end) of the table to the statistics
+     * @pre rows before begin were scanned first, so ties keep the earliest row
+     */
+    void scan(const CameraTable& cameraTable, size_t begin, size_t end) {
+        const int32_t* violations = cameraTable.getVioColumn().data();
+        const int32_t* cameraIds = cameraTable.getCamColumn().data();
+        seenCameras.resize((cameraTable.getCamCount() + 63) / 64, 0);
+
+        for (size_t i = begin; i < end; i++) {
+            int32_t numViolations = violations[i];
+            totalViolations += numViolations;
+            if (numViolations > maxViolations) {
+                maxViolations = numViolations;
+                maxRow = i;
+            }
+            seenCameras[cameraIds[i] >> 6] |= 1ull << (cameraIds[i] & 63);
+        }
+        records += end - begin;
+    }
+
+    /**
+     * Combines the statistics of a later row range into this one
+     * @pre other covers rows after the ones in this object
+     */
+    void merge(const OverviewStats& other) {
+        records += other.records;
+        totalViolations += other.totalViolations;
+        if (other.maxViolations > maxViolations) {
+            maxViolations = other.maxViolations;
+            maxRow = other.maxRow;
+        }
+        if (seenCameras.size() < other.seenCameras.size()) {
+            seenCameras.resize(other.seenCameras.size(), 0);
+        }
+        for (size_t i = 0; i < other.seenCameras.size(); i++) {
+            seenCameras[i] |= other.seenCameras[i];
+        }
+    }
+
+    // Getters
+    int64_t getRecords() const { return records; }
+    int64_t getTotalViolations() const { return totalViolations; }
+    int32_t getMaxViolations() const { return maxViolations; }
+    size_t getMaxRow() const { return maxRow; }
+    int32_t getCameraCount() const {
+        int32_t count = 0;
+        for (uint64_t word : seenCameras) {
+            count += __builtin_popcountll(word);
+        }
+        return count;
+    }
+
+    // Writes the statistics to a snapshot
+    void save(SnapshotWriter& writer) const {
+        writer.values(vector<int64_t>{records, totalViolations, maxViolations, (int64_t)maxRow});
+        writer.values(seenCameras);
+    }
+
+    /**
+     * Replaces the statistics with ones written by save()
+     * @return true if the snapshot held a complete set of statistics
+     */
+    bool load(SnapshotReader& reader) {
+        vector<int64_t> scalars;
+        if (!reader.values(scalars) || scalars.size() != 4 || !reader.values(seenCameras)) {
+            return false;
+        }
+        records = scalars[0];
+        totalViolations = scalars[1];
+        maxViolations = scalars[2];
+        maxRow = scalars[3];
+        return true;
+    }
+};
+
+// Class that totals violations and rows for each month number in one pass
+// Totals of separate row ranges can be merged
+class MonthTotals {
+private:
+    // Indexed by the 4 month bits of a packed date; only 1-12 are real months
+    array<int64_t, 16> violations;
+    array<int64_t, 16> rows;
+public:
+    // Constructor
+    MonthTotals() : violations{}, rows{} {}
+
+    // Adds rows [begin, end) of the table to the totals
+    void scan(const CameraTable& cameraTable, size_t begin, size_t end) {
+        const uint32_t* dates = cameraTable.getDateColumn().data();
+        const int32_t* vio = cameraTable.getVioColumn().data();
+        for (size_t i = begin; i < end; i++) {
+            int monthInt = dateMonth(dates[i]);
+            violations[monthInt] += vio[i];
+            rows[monthInt]++;
+        }
+    }
+
+    // Adds the totals of another row range
+    void merge(const MonthTotals& other) {
+        for (int monthInt = 0; monthInt < 16; monthInt++) {
+            violations[monthInt] += other.violations[monthInt];
+            rows[monthInt] += other.rows[monthInt];
+        }
+    }
+
+    // Adds totals that were counted elsewhere for one month number
+    void add(int monthInt, int64_t monthViolations, int64_t monthRows) {
+        violations[monthInt] += monthViolations;
+        rows[monthInt] += monthRows;
+    }
+
+    // Getters for one month number (1-12)
+    int64_t getViolations(int monthInt) const { return violations[monthInt]; }
+    bool hasMonth(int monthInt) const { return rows[monthInt] > 0; }
+};
+
+// Class that keeps the overview, neighborhood and month aggregates up to date
+// as rows are appended to a table, scanning only the rows added since the last update
+class IncrementalReports {
+private:
+    OverviewStats overview;
+    GroupAggregator neighborhoods;
+    MonthTotals months;
+    size_t rowsSeen; // Rows already added to the aggregates
+public:
+    // Constructor
+    IncrementalReports() : rowsSeen(0) {}
+
+    /**
+     * Adds the rows appended to the table since the last call
+     * @pre rows are only ever appended, so earlier rows and ids are unchanged
+     * @return number of new rows
+     */
+    size_t update(const CameraTable& cameraTable) {
+        size_t rows = cameraTable.size();
+        overview.scan(cameraTable, rowsSeen, rows);
+        months.scan(cameraTable, rowsSeen, rows);
+        const vector<int32_t>& neighborhoodIds = cameraTable.getNeighColumn();
+        const vector<int32_t>& cameraIds = cameraTable.getCamColumn();
+        const vector<int32_t>& violations = cameraTable.getVioColumn();
+        for (size_t i = rowsSeen; i < rows; i++) {
+            neighborhoods.add(neighborhoodIds[i], violations[i], cameraIds[i]);
+        }
+        size_t added = rows - rowsSeen;
+        rowsSeen = rows;
+        return added;
+    }
+
+    // Getters
+    const OverviewStats& getOverview() const { return overview; }
+    const GroupAggregator& getNeighborhoods() const { return neighborhoods; }
+    const MonthTotals& getMonths() const { return months; }
+};
+
+// Class that holds the aggregates every report is answered from, built once after loading:
+// - the overview statistics
+// - per neighborhood totals, and per neighborhood x month totals
+// - per camera totals, and per camera x day totals sorted by date
+// The cube is saved in the snapshot next to the table, so later sessions skip the build
+class RollupCube {
+private:
+    OverviewStats overview;
+    // Neighborhoods in order of first appearance, with their totals
+    vector<int32_t> neighborhoodIds;
+    vector<int64_t> neighborhoodViolations;
+    vector<int64_t> neighborhoodRows;
+    vector<int32_t> neighborhoodCameras; // Distinct cameras
+    // Violations and rows of neighborhood id n in month m at [n * 16 + m]
+    vector<int64_t> neighborhoodMonthViolations;
+    vector<int64_t> neighborhoodMonthRows;
+    // Totals of each camera id
+    vector<int64_t> cameraViolations;
+    vector<int64_t> cameraRows;
+    // Days of camera id c are at [dayOffsets[c], dayOffsets[c + 1]), in date order
+    vector<uint64_t> dayOffsets;
+    vector<uint32_t> dayDates;
+    vector<int64_t> dayViolations;
+
+public:
+    /**
+     * Builds every aggregate from a table
+     * Row ranges are scanned on separate threads and merged in row order, and
+     * each camera's days are sorted on its own task
+     * @param threads Number of threads
+     */
+    void build(const CameraTable& cameraTable, int threads) {
+        ScopedTimer timer("rollup build", cameraTable.size());
+        const vector<int32_t>& neighborhoods = cameraTable.getNeighColumn();
+        const vector<int32_t>& cameras = cameraTable.getCamColumn();
+        const vector<int32_t>& violations = cameraTable.getVioColumn();
+        const vector<uint32_t>& dates = cameraTable.getDateColumn();
+        size_t rows = cameraTable.size();
+        int32_t neighCount = cameraTable.getNeighCount();
+        int32_t camCount = cameraTable.getCamCount();
+
+        // One pass per row range for everything that is summed
+        struct Partial {
+            OverviewStats overview;
+            GroupAggregator groups;
+            vector<int64_t> monthViolations, monthRows, camViolations, camRows;
+            HashMap dayIndex;         // camera << 32 | date to a position in dayKeys
+            vector<uint64_t> dayKeys;
+            vector<int64_t> daySums;
+        };
+        size_t ranges = scanRanges(rows, threads);
+        vector<Partial> partials(ranges);
+        parallelFor(ranges, threads, [&](size_t r) {
+            Partial& partial = partials[r];
+            partial.monthViolations.assign(neighCount * 16, 0);
+            partial.monthRows.assign(neighCount * 16, 0);
+            partial.camViolations.assign(camCount, 0);
+            partial.camRows.assign(camCount, 0);
+            size_t begin = rows * r / ranges, end = rows * (r + 1) / ranges;
+            partial.overview.scan(cameraTable, begin, end);
+            for (size_t i = begin; i < end; i++) {
+                partial.groups.add(neighborhoods[i], violations[i], cameras[i]);
+                size_t cell = neighborhoods[i] * 16 + dateMonth(dates[i]);
+                partial.monthViolations[cell] += violations[i];
+                partial.monthRows[cell]++;
+                partial.camViolations[cameras[i]] += violations[i];
+                partial.camRows[cameras[i]]++;
+                uint64_t dayKey = (uint64_t)cameras[i] << 32 | dates[i];
+                int32_t day = partial.dayIndex.findOrInsert(dayKey, partial.dayKeys.size());
+                if (day == (int32_t)partial.dayKeys.size()) {
+                    partial.dayKeys.push_back(dayKey);
+                    partial.daySums.push_back(0);
+                }
+                partial.daySums[day] += violations[i];
+            }
+        });
+
+        overview = OverviewStats();
+        GroupAggregator groups;
+        neighborhoodMonthViolations.assign(neighCount * 16, 0);
+        neighborhoodMonthRows.assign(neighCount * 16, 0);
+        cameraViolations.assign(camCount, 0);
+        cameraRows.assign(camCount, 0);
+        for (const Partial& partial : partials) {
+            overview.merge(partial.overview);
+            groups.merge(partial.groups);
+            for (size_t cell = 0; cell < neighborhoodMonthViolations.size(); cell++) {
+                neighborhoodMonthViolations[cell] += partial.monthViolations[cell];
+                neighborhoodMonthRows[cell] += partial.monthRows[cell];
+            }
+            for (int32_t c = 0; c < camCount; c++) {
+                cameraViolations[c] += partial.camViolations[c];
+                cameraRows[c] += partial.camRows[c];
+            }
+        }
+        neighborhoodIds.clear();
+        neighborhoodViolations.clear();
+        neighborhoodRows.clear();
+        neighborhoodCameras.clear();
+        for (int32_t group = 0; group < groups.size(); group++) {
+            neighborhoodIds.push_back(groups.getKey(group));
+            neighborhoodViolations.push_back(groups.getSum(group));
+            neighborhoodRows.push_back(groups.getRows(group));
+            neighborhoodCameras.push_back(groups.getDistinct(group));
+        }
+
+        // Combine the camera x day cells of every range, then order them by camera and date
+        HashMap dayIndex;
+        vector<pair<uint64_t, int64_t>> days;
+        for (const Partial& partial : partials) {
+            for (size_t d = 0; d < partial.dayKeys.size(); d++) {
+                int32_t day = dayIndex.findOrInsert(partial.dayKeys[d], days.size());
+                if (day == (int32_t)days.size()) {
+                    days.push_back(make_pair(partial.dayKeys[d], 0));
+                }
+                days[day].second += partial.daySums[d];
+            }
+        }
+        sort(days.begin(), days.end());
+        dayOffsets.assign(camCount + 1, 0);
+        dayDates.resize(days.size());
+        dayViolations.resize(days.size());
+        for (size_t d = 0; d < days.size(); d++) {
+            dayOffsets[(days[d].first >> 32) + 1]++;
+            dayDates[d] = (uint32_t)days[d].first;
+            dayViolations[d] = days[d].second;
+        }
+        for (int32_t c = 0; c < camCount; c++) {
+            dayOffsets[c + 1] += dayOffsets[c];
+        }
+    }
+
+    // Overview statistics of the whole table
+    const OverviewStats& getOverview() const { return overview; }
+
+    // Neighborhood totals as groups keyed by neighborhood id, in order of first appearance
+    GroupAggregator neighborhoodGroups() const {
+        GroupAggregator groups;
+        for (size_t n = 0; n < neighborhoodIds.size(); n++) {
+            groups.addTotals(neighborhoodIds[n], neighborhoodViolations[n], neighborhoodRows[n], neighborhoodCameras[n]);
+        }
+        return groups;
+    }
+
+    // Totals of each month number, over every neighborhood
+    MonthTotals monthTotals() const {
+        MonthTotals months;
+        for (size_t cell = 0; cell < neighborhoodMonthViolations.size(); cell++) {
+            months.add(cell & 15, neighborhoodMonthViolations[cell], neighborhoodMonthRows[cell]);
+        }
+        return months;
+    }
+
+    // Totals of one neighborhood id in one month number
+    int64_t getNeighMonthViolations(int32_t neighborhood, int monthInt) const {
+        return neighborhoodMonthViolations[neighborhood * 16 + monthInt];
+    }
+
+    // Totals of one camera id
+    int64_t getCamViolations(int32_t camera) const { return cameraViolations[camera]; }
+    int64_t getCamRows(int32_t camera) const { return cameraRows[camera]; }
+
+    // Days of one camera id: dates and violations from index getDayBegin() up to getDayEnd()
+    uint64_t getDayBegin(int32_t camera) const { return dayOffsets[camera]; }
+    uint64_t getDayEnd(int32_t camera) const { return dayOffsets[camera + 1]; }
+    const vector<uint32_t>& getDayDates() const { return dayDates; }
+    const vector<int64_t>& getDayViolations() const { return dayViolations; }
+
+    // Writes every aggregate to a snapshot
+    void save(SnapshotWriter& writer) const {
+        overview.save(writer);
+        writer.values(neighborhoodIds);
+        writer.values(neighborhoodViolations);
+        writer.values(neighborhoodRows);
+        writer.values(neighborhoodCameras);
+        writer.values(neighborhoodMonthViolations);
+        writer.values(neighborhoodMonthRows);
+        writer.values(cameraViolations);
+        writer.values(cameraRows);
+        writer.values(dayOffsets);
+        writer.values(dayDates);
+        writer.values(dayViolations);
+    }
+
+    /**
+     * Replaces the aggregates with ones written by save()
+     * @param cameraTable The table the cube was built from, already loaded
+     * @return true if the snapshot was complete and matches the table's dictionaries
+     */
+    bool load(SnapshotReader& reader, const CameraTable& cameraTable) {
+        if (!overview.load(reader) || !reader.values(neighborhoodIds) || !reader.values(neighborhoodViolations)
+            || !reader.values(neighborhoodRows) || !reader.values(neighborhoodCameras)
+            || !reader.values(neighborhoodMonthViolations) || !reader.values(neighborhoodMonthRows)
+            || !reader.values(cameraViolations) || !reader.values(cameraRows) || !reader.values(dayOffsets)
+            || !reader.values(dayDates) || !reader.values(dayViolations)) {
+            return false;
+        }
+        size_t neighCount = cameraTable.getNeighCount(), camCount = cameraTable.getCamCount();
+        size_t groupCount = neighborhoodIds.size();
+        if (groupCount > neighCount || neighborhoodViolations.size() != groupCount
+            || neighborhoodRows.size() != groupCount || neighborhoodCameras.size() != groupCount
+            || neighborhoodMonthViolations.size() != neighCount * 16 || neighborhoodMonthRows.size() != neighCount * 16
+            || cameraViolations.size() != camCount || cameraRows.size() != camCount
+            || dayOffsets.size() != camCount + 1 || dayOffsets[camCount] != dayDates.size()
+            || dayViolations.size() != dayDates.size() || overview.getMaxRow() >= max<size_t>(cameraTable.size(), 1)) {
+            return false;
+        }
+        for (int32_t neighborhood : neighborhoodIds) {
+            if ((uint32_t)neighborhood >= neighCount) {
+                return false;
+            }
+        }
+        for (size_t c = 0; c < camCount; c++) {
+            if (dayOffsets[c] > dayOffsets[c + 1]) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Bytes held by the aggregates
+    size_t memoryUsage() const {
+        return (neighborhoodIds.capacity() + neighborhoodCameras.capacity() + dayDates.capacity()) * 4
+            + (neighborhoodViolations.capacity() + neighborhoodRows.capacity()
+               + neighborhoodMonthViolations.capacity() + neighborhoodMonthRows.capacity()
+               + cameraViolations.capacity() + cameraRows.capacity()
+               + dayOffsets.capacity() + dayViolations.capacity()) * 8;
+    }
+};
+
+// Class that orders the rows by date so any date range is one contiguous run of rows
+// It also keeps the total violations of each distinct date, so day and month
+// questions only touch the distinct dates inside the range
+class DateIndex {
+private:
+    vector<uint32_t> rowsByDate;    // Row numbers sorted by date, file order within a date
+    vector<uint32_t> dates;         // Distinct dates, ascending
+    vector<uint64_t> dateStarts;    // Rows of dates[d] are rowsByDate[dateStarts[d] .. dateStarts[d + 1])
+    vector<int64_t> dateViolations; // Total violations of each distinct date
+    bool built;
+
+public:
+    // Constructor
+    DateIndex() : built(false) {}
+
+    /**
+     * Sorts the rows by date with a counting sort over the distinct dates
+     * @post every row is in exactly one date run
+     */
+    void build(const CameraTable& cameraTable) {
+        ScopedTimer timer("date index build", cameraTable.size());
+        const vector<uint32_t>& rowDates = cameraTable.getDateColumn();
+        const vector<int32_t>& violations = cameraTable.getVioColumn();
+        size_t rows = cameraTable.size();
+
+        // Give each distinct date a dense number in date order
+        dates.assign(rowDates.begin(), rowDates.end());
+        sort(dates.begin(), dates.end());
+        dates.erase(unique(dates.begin(), dates.end()), dates.end());
+        HashMap dateNumbers(dates.size());
+        for (size_t d = 0; d < dates.size(); d++) {
+            dateNumbers.findOrInsert(dates[d], d);
+        }
+
+        // Count, then place each row after the rows of earlier dates
+        vector<int32_t> rowDateNumbers(rows);
+        dateStarts.assign(dates.size() + 1, 0);
+        dateViolations.assign(dates.size(), 0);
+        for (size_t i = 0; i < rows; i++) {
+            int32_t d = dateNumbers.find(rowDates[i]);
+            rowDateNumbers[i] = d;
+            dateStarts[d + 1]++;
+            dateViolations[d] += violations[i];
+        }
+        for (size_t d = 0; d < dates.size(); d++) {
+            dateStarts[d + 1] += dateStarts[d];
+        }
+        vector<uint64_t> fill(dateStarts.begin(), dateStarts.end() - 1);
+        rowsByDate.resize(rows);
+        for (size_t i = 0; i < rows; i++) {
+            rowsByDate[fill[rowDateNumbers[i]]++] = i;
+        }
+        built = true;
+    }
+
+    // Whether build() has run
+    bool isBuilt() const { return built; }
+
+    /**
+     * Finds the distinct dates inside a range
+     * @param from First date included (packed)
+     * @param to Last date included (packed)
+     * @return [first, last) positions in the distinct dates
+     */
+    pair<size_t, size_t> dateRange(uint32_t from, uint32_t to) const {
+        size_t first = lower_bound(dates.begin(), dates.end(), from) - dates.begin();
+        size_t last = upper_bound(dates.begin(), dates.end(), to) - dates.begin();
+        return make_pair(first, max(first, last));
+    }
+
+    // Getters for one distinct date position
+    uint32_t getDate(size_t d) const { return dates[d]; }
+    int64_t getDateViolations(size_t d) const { return dateViolations[d]; }
+    uint64_t getDateStart(size_t d) const { return dateStarts[d]; }
+
+    // Row numbers in date order
+    const vector<uint32_t>& getRowsByDate() const { return rowsByDate; }
+};
+
+// Class that indexes the distinct intersections and neighborhoods by trigram
+// (every run of three characters, lowercased) so a substring search only has
+// to check the texts that contain all of the search term's trigrams
+class SearchIndex {
+private:
+    vector<string> texts;          // Lowercased intersections, then lowercased neighborhoods
+    int32_t intersectionCount;     // Texts below this index are intersections
+    HashMap trigramIndex;          // Trigram to its position in trigramPostings
+    vector<vector<int32_t>> trigramPostings; // Sorted text numbers containing each trigram
+    vector<vector<pair<int32_t, size_t>>> textCameras; // (camera id, first row) for each text
+    bool built;                    // Whether build() has run
+
+    // Packs three characters into one key
+    static uint64_t trigramKey(const char* c) {
+        return (uint64_t)(unsigned char)c[0] << 16 | (uint64_t)(unsigned char)c[1] << 8 | (unsigned char)c[2];
+    }
+
+    // Adds a row's camera to a text unless the pair was already seen
+    void addCamera(HashMap& seenPairs, int32_t text, int32_t camID, size_t row) {
+        if (seenPairs.insert((uint64_t)text << 32 | (uint32_t)camID)) {
+            textCameras[text].emplace_back(camID, row);
+        }
+    }
+public:
+    // Constructor
+    SearchIndex() : intersectionCount(0), built(false) {}
+
+    /**
+     * Builds the index for a table
+     * @post every distinct intersection and neighborhood is indexed along with
+     *       the cameras found with it and the first row each camera was found on
+     */
+    void build(const CameraTable& cameraTable) {
+        ScopedTimer timer("search index build", cameraTable.size());
+        intersectionCount = cameraTable.getInterCount();
+        texts.clear();
+        for (int32_t id = 0; id < cameraTable.getInterCount(); id++) {
+            texts.emplace_back(cameraTable.getInter(id));
+        }
+        for (int32_t id = 0; id < cameraTable.getNeighCount(); id++) {
+            texts.emplace_back(cameraTable.getNeigh(id));
+        }
+
+        // Lowercase every text once and record its trigrams
+        trigramIndex = HashMap();
+        trigramPostings.clear();
+        for (int32_t text = 0; text < (int32_t)texts.size(); text++) {
+            string& value = texts[text];
+            transform(value.begin(), value.end(), value.begin(), ::tolower);
+            for (size_t i = 0; i + 3 <= value.size(); i++) {
+                int32_t list = trigramIndex.findOrInsert(trigramKey(&value[i]), trigramPostings.size());
+                if (list == (int32_t)trigramPostings.size()) {
+                    trigramPostings.emplace_back();
+                }
+                // Texts are added in order, so each list stays sorted without duplicates
+                if (trigramPostings[list].empty() || trigramPostings[list].back() != text) {
+                    trigramPostings[list].push_back(text);
+                }
+            }
+        }
+
+        // Link each text to the cameras that appear with it
+        textCameras.assign(texts.size(), {});
+        const vector<int32_t>& cameraIds = cameraTable.getCamColumn();
+        const vector<int32_t>& intersectionIds = cameraTable.getInterColumn();
+        const vector<int32_t>& neighborhoodIds = cameraTable.getNeighColumn();
+        HashMap seenPairs;
+        for (size_t i = 0; i < cameraIds.size(); i++) {
+            addCamera(seenPairs, intersectionIds[i], cameraIds[i], i);
+            addCamera(seenPairs, intersectionCount + neighborhoodIds[i], cameraIds[i], i);
+        }
+        built = true;
+    }
+
+    // Whether the index can answer searches
+    bool isBuilt() const { return built; }
+
+    /**
+     * Finds the cameras whose intersection or neighborhood contains a search term
+     * @param searchTerm Lowercase term to look for
+     * @return for each matching camera, the first row where its intersection or
+     *         neighborhood matches, in row order
+     */
+    vector<size_t> search(const string& searchTerm) const {
+        // Texts containing every trigram of the term are candidates; short terms check every text
+        vector<int32_t> candidates;
+        if (searchTerm.size() < 3) {
+            for (int32_t text = 0; text < (int32_t)texts.size(); text++) {
+                candidates.push_back(text);
+            }
+        }
+        else {
+            for (size_t i = 0; i + 3 <= searchTerm.size(); i++) {
+                int32_t list = trigramIndex.find(trigramKey(&searchTerm[i]));
+                if (list == -1) {
+                    return {}; // A trigram no text has, so nothing can match
+                }
+                if (i == 0) {
+                    candidates = trigramPostings[list];
+                }
+                else {
+                    vector<int32_t> both;
+                    set_intersection(candidates.begin(), candidates.end(),
+                                     trigramPostings[list].begin(), trigramPostings[list].end(), back_inserter(both));
+                    candidates.swap(both);
+                }
+            }
+        }
+
+        // Confirm each candidate and keep the earliest row seen for each camera
+        HashMap cameraSlot;
+        vector<size_t> firstRows;
+        for (int32_t text : candidates) {
+            if (texts[text].find(searchTerm) == string::npos) {
+                continue;
+            }
+            for (const pair<int32_t, size_t>& camera : textCameras[text]) {
+                int32_t slot = cameraSlot.findOrInsert(camera.first, firstRows.size());
+                if (slot == (int32_t)firstRows.size()) {
+                    firstRows.push_back(camera.second);
+                }
+                else {
+                    firstRows[slot] = min(firstRows[slot], camera.second);
+                }
+            }
+        }
+        sort(firstRows.begin(), firstRows.end());
+        return firstRows;
+    }
+};
+
+// Class that estimates how many distinct keys it has seen (HyperLogLog)
+// 4096 one-byte registers give a standard error of about 1.6% whatever the count
+// Sketches of different row sets merge into the sketch of their union
+class HyperLogLog {
+private:
+    static const int PRECISION = 12; // The top 12 bits of a hash pick the register
+    array<uint8_t, 1 << PRECISION> registers = {};
+
+public:
+    // Adds a key by its hash, which must be well mixed (see CameraSketches::hashText())
+    void add(uint64_t hash) {
+        size_t index = hash >> (64 - PRECISION);
+        // Rank of the first set bit in the rest of the hash; the marker bit caps it
+        uint64_t rest = hash << PRECISION | (1ull << (PRECISION - 1));
+        uint8_t rank = __builtin_clzll(rest) + 1;
+        registers[index] = max(registers[index], rank);
+    }
+
+    // Combines the keys of another sketch into this one
+    void merge(const HyperLogLog& other) {
+        for (size_t r = 0; r < registers.size(); r++) {
+            registers[r] = max(registers[r], other.registers[r]);
+        }
+    }
+
+    // Estimated number of distinct keys, counting empty registers for small sets
+    int64_t estimate() const {
+        double m = registers.size();
+        double sum = 0;
+        int zeros = 0;
+        for (uint8_t rank : registers) {
+            sum += ldexp(1.0, -rank);
+            zeros += rank == 0;
+        }
+        double estimate = 0.7213 / (1 + 1.079 / m) * m * m / sum;
+        if (estimate <= 2.5 * m && zeros > 0) {
+            estimate = m * log(m / zeros);
+        }
+        return llround(estimate);
+    }
+};
+
+// Class that estimates the total weight of any key in fixed memory (Count-Min)
+// An estimate is never too low and, with 98% confidence, too high by at most
+// e / 2048 (0.13%) of the total weight
+class CountMinSketch {
+private:
+    static const int DEPTH = 4;
+    static const size_t WIDTH = 2048;
+    vector<int64_t> counts;
+    int64_t total;
+
+    // Cell of a key in one row, from two halves of its hash (double hashing)
+    static size_t cell(int row, uint64_t hash) {
+        uint64_t h = (uint32_t)hash + row * ((hash >> 32) | 1);
+        return row * WIDTH + (h & (WIDTH - 1));
+    }
+
+public:
+    // Constructor
+    CountMinSketch() : counts(DEPTH * WIDTH, 0), total(0) {}
+
+    void add(uint64_t hash, int64_t weight) {
+        for (int row = 0; row < DEPTH; row++) {
+            counts[cell(row, hash)] += weight;
+        }
+        total += weight;
+    }
+
+    void merge(const CountMinSketch& other) {
+        for (size_t c = 0; c < counts.size(); c++) {
+            counts[c] += other.counts[c];
+        }
+        total += other.total;
+    }
+
+    // Upper estimate of a key's weight
+    int64_t estimate(uint64_t hash) const {
+        int64_t smallest = counts[cell(0, hash)];
+        for (int row = 1; row < DEPTH; row++) {
+            smallest = min(smallest, counts[cell(row, hash)]);
+        }
+        return smallest;
+    }
+
+    // How far estimate() may be too high
+    int64_t errorBound() const {
+        return (int64_t)ceil(exp(1.0) * total / WIDTH);
+    }
+};
+
+// Class that keeps the heaviest keys of a weighted stream in a fixed number
+// of counters (Space-Saving). A new key takes over the smallest counter, so
+// every count is an upper estimate that is at most its error too high, and
+// any key heavier than total / capacity is sure to be kept
+class SpaceSaving {
+public:
+    struct Counter {
+        uint64_t key;
+        string_view name; // Points into the dictionary of the table the key came from
+        int64_t count;
+        int64_t error;    // How much of count may belong to keys it replaced
+    };
+
+private:
+    size_t capacity;
+    vector<Counter> counters;
+
+    // Smallest count a key not in the summary could have had
+    int64_t missingCount() const {
+        if (counters.size() < capacity) {
+            return 0;
+        }
+        int64_t smallest = counters[0].count;
+        for (const Counter& counter : counters) {
+            smallest = min(smallest, counter.count);
+        }
+        return smallest;
+    }
+
+public:
+    // Constructor
+    explicit SpaceSaving(size_t capacity = 64) : capacity(capacity) {}
+
+    void add(uint64_t key, string_view name, int64_t weight) {
+        for (Counter& counter : counters) {
+            if (counter.key == key) {
+                counter.count += weight;
+                return;
+            }
+        }
+        if (counters.size() < capacity) {
+            counters.push_back({key, name, weight, 0});
+            return;
+        }
+        Counter& smallest = *min_element(counters.begin(), counters.end(),
+            [](const Counter& a, const Counter& b) { return a.count < b.count; });
+        smallest = {key, name, smallest.count + weight, smallest.count};
+    }
+
+    /**
+     * Combines the summary of another row set into this one
+     * A key missing from a full summary may have had up to that summary's
+     * smallest count there, so that much is added to its count and error
+     */
+    void merge(const SpaceSaving& other) {
+        int64_t ownMissing = missingCount(), otherMissing = other.missingCount();
+        vector<Counter> merged = counters;
+        for (Counter& counter : merged) {
+            auto match = find_if(other.counters.begin(), other.counters.end(),
+                                 [&](const Counter& o) { return o.key == counter.key; });
+            counter.count += match != other.counters.end() ? match->count : otherMissing;
+            counter.error += match != other.counters.end() ? match->error : otherMissing;
+        }
+        for (const Counter& o : other.counters) {
+            if (none_of(counters.begin(), counters.end(), [&](const Counter& c) { return c.key == o.key; })) {
+                merged.push_back({o.key, o.name, o.count + ownMissing, o.error + ownMissing});
+            }
+        }
+        counters = top(merged.size(), merged);
+        counters.resize(min(counters.size(), capacity));
+    }
+
+    // The k heaviest counters, heaviest first (ties by name)
+    vector<Counter> top(size_t k) const {
+        return top(k, counters);
+    }
+
+private:
+    static vector<Counter> top(size_t k, vector<Counter> list) {
+        sort(list.begin(), list.end(), [](const Counter& a, const Counter& b) {
+            return a.count != b.count ? a.count > b.count : a.name < b.name;
+        });
+        list.resize(min(k, list.size()));
+        return list;
+    }
+};
+
+// Class that holds approximate statistics of a set of rows in fixed memory:
+// distinct cameras citywide and per neighborhood (HyperLogLog) and the
+// intersections with the most violations (Space-Saving, checked with Count-Min)
+// Keys are hashed from their text rather than dictionary ids, so sketches of
+// different files, tables and threads merge; names point into the tables' dictionaries
+class CameraSketches {
+private:
+    HyperLogLog cameras;
+    HashMap neighborhoodIndex;              // Neighborhood name hash to position below
+    vector<string_view> neighborhoodNames;
+    vector<HyperLogLog> neighborhoodCameras;
+    SpaceSaving intersections;
+    CountMinSketch intersectionViolations;
+
+    // Sketch of one neighborhood, added when it is first seen
+    HyperLogLog& neighborhood(uint64_t hash, string_view name) {
+        int32_t index = neighborhoodIndex.findOrInsert(hash, neighborhoodNames.size());
+        if (index == (int32_t)neighborhoodNames.size()) {
+            neighborhoodNames.push_back(name);
+            neighborhoodCameras.emplace_back();
+        }
+        return neighborhoodCameras[index];
+    }
+
+public:
+    // FNV-1a hash of a text with its bits spread (splitmix64 finalizer), as the sketches need
+    static uint64_t hashText(string_view text) {
+        return HashMap::mix(StringPool::hash(text));
+    }
+
+    /**
+     * Builds the sketches of a table. Every region (source file) gets its own
+     * sketches, from row ranges scanned on separate threads and merged; the
+     * citywide sketches are then the merge of the regions
+     * @param threads Number of threads
+     */
+    void build(const CameraTable& cameraTable, int threads) {
+        ScopedTimer timer("sketch build", cameraTable.size());
+        // Hash every dictionary entry once instead of every row's text
+        auto hashDictionary = [](int32_t count, auto get) {
+            vector<uint64_t> hashes(count);
+            for (int32_t id = 0; id < count; id++) {
+                hashes[id] = hashText(get(id));
+            }
+            return hashes;
+        };
+        vector<uint64_t> cameraHashes = hashDictionary(cameraTable.getCamCount(), [&](int32_t id) { return cameraTable.getCamNum(id); });
+        vector<uint64_t> neighHashes = hashDictionary(cameraTable.getNeighCount(), [&](int32_t id) { return cameraTable.getNeigh(id); });
+        vector<uint64_t> interHashes = hashDictionary(cameraTable.getInterCount(), [&](int32_t id) { return cameraTable.getInter(id); });
+
+        const vector<int32_t>& regions = cameraTable.getRegionColumn();
+        const vector<int32_t>& cameraIds = cameraTable.getCamColumn();
+        const vector<int32_t>& neighIds = cameraTable.getNeighColumn();
+        const vector<int32_t>& interIds = cameraTable.getInterColumn();
+        const vector<int32_t>& violations = cameraTable.getVioColumn();
+        size_t rows = cameraTable.size();
+        size_t ranges = scanRanges(rows, threads);
+        int32_t regionCount = cameraTable.getRegionCount();
+        vector<vector<CameraSketches>> partials(ranges);
+        parallelFor(ranges, threads, [&](size_t r) {
+            vector<CameraSketches>& byRegion = partials[r];
+            byRegion.resize(regionCount);
+            for (size_t i = rows * r / ranges; i < rows * (r + 1) / ranges; i++) {
+                CameraSketches& sketches = byRegion[regions[i]];
+                sketches.cameras.add(cameraHashes[cameraIds[i]]);
+                sketches.neighborhood(neighHashes[neighIds[i]], cameraTable.getNeigh(neighIds[i]))
+                        .add(cameraHashes[cameraIds[i]]);
+                sketches.intersections.add(interHashes[interIds[i]], cameraTable.getInter(interIds[i]), violations[i]);
+                sketches.intersectionViolations.add(interHashes[interIds[i]], violations[i]);
+            }
+        });
+
+        ScopedTimer mergeTimer("merge", regionCount);
+        *this = CameraSketches();
+        for (int32_t region = 0; region < regionCount; region++) {
+            CameraSketches regionSketches;
+            for (vector<CameraSketches>& byRegion : partials) {
+                regionSketches.merge(byRegion[region]);
+            }
+            merge(regionSketches);
+        }
+    }
+
+    // Combines the sketches of another row set into these
+    void merge(const CameraSketches& other) {
+        cameras.merge(other.cameras);
+        for (size_t n = 0; n < other.neighborhoodNames.size(); n++) {
+            string_view name = other.neighborhoodNames[n];
+            neighborhood(hashText(name), name).merge(other.neighborhoodCameras[n]);
+        }
+        intersections.merge(other.intersections);
+        intersectionViolations.merge(other.intersectionViolations);
+    }
+
+    // Estimated number of distinct cameras
+    int64_t getCameraCount() const { return cameras.estimate(); }
+
+    // Estimated number of distinct cameras in a neighborhood, 0 if it was never seen
+    int64_t getNeighborhoodCameras(string_view name) const {
+        int32_t index = neighborhoodIndex.find(hashText(name));
+        return index < 0 ? 0 : neighborhoodCameras[index].estimate();
+    }
+
+    /**
+     * The intersections with the most violations
+     * Each count is the lower of the Space-Saving and Count-Min estimates, so it is never too low
+     * @param k Number of intersections
+     * @return (counter, largest possible overestimate of its count) pairs, heaviest first
+     */
+    vector<pair<SpaceSaving::Counter, int64_t>> topIntersections(size_t k) const {
+        // Every kept counter is a candidate, since Count-Min can lower the order
+        vector<pair<SpaceSaving::Counter, int64_t>> result;
+        for (SpaceSaving::Counter counter : intersections.top(SIZE_MAX)) {
+            int64_t lowest = counter.count - counter.error; // Violations it surely has
+            counter.count = min(counter.count, intersectionViolations.estimate(counter.key));
+            result.push_back(make_pair(counter, counter.count - lowest));
+        }
+        sort(result.begin(), result.end(), [](const pair<SpaceSaving::Counter, int64_t>& a,
+                                              const pair<SpaceSaving::Counter, int64_t>& b) {
+            return a.first.count != b.first.count ? a.first.count > b.first.count : a.first.name < b.first.name;
+        });
+        result.resize(min(k, result.size()));
+        return result;
+    }
+};
+
+// Class that holds a set of row numbers as a roaring-style bitmap
+// Rows are split into chunks of 65536; a chunk stores its rows either as a
+// sorted array of 16-bit offsets (up to 4096 rows, 8 KB at most) or as a
+// 65536-bit bitset (8 KB), so sparse and dense sets both stay small and
+// AND / OR work chunk by chunk without looking at rows outside the set
+class RowBitmap {
+private:
+    static const size_t ARRAY_LIMIT = 4096; // A chunk with more rows is a bitset
+    static const size_t BITSET_WORDS = 1024;
+
+    struct Chunk {
+        uint64_t high = 0;     // The chunk holds rows high << 16 to (high << 16) + 65535
+        vector<uint16_t> rows; // Sorted offsets, when the chunk is an array
+        vector<uint64_t> bits; // Bit per offset, when the chunk is a bitset
+        uint32_t count = 0;    // Rows in the chunk
+
+        bool isBitset() const { return !bits.empty(); }
+        bool contains(uint16_t low) const {
+            return isBitset() ? (bits[low >> 6] >> (low & 63) & 1) : binary_search(rows.begin(), rows.end(), low);
+        }
+    };
+    vector<Chunk> chunks; // In row order, only chunks that have rows
+
+    // Stores a chunk in the smaller of the two forms after it changed
+    static void normalize(Chunk& chunk) {
+        if (!chunk.isBitset() && chunk.rows.size() > ARRAY_LIMIT) {
+            chunk.bits.assign(BITSET_WORDS, 0);
+            for (uint16_t low : chunk.rows) {
+                chunk.bits[low >> 6] |= 1ull << (low & 63);
+            }
+            vector<uint16_t>().swap(chunk.rows);
+        }
+        else if (chunk.isBitset() && chunk.count <= ARRAY_LIMIT) {
+            chunk.rows.clear();
+            for (size_t w = 0; w < BITSET_WORDS; w++) {
+                for (uint64_t word = chunk.bits[w]; word != 0; word &= word - 1) {
+                    chunk.rows.push_back(w * 64 + __builtin_ctzll(word));
+                }
+            }
+            vector<uint64_t>().swap(chunk.bits);
+        }
+    }
+
+    // Rows in both chunks
+    static Chunk intersect(const Chunk& a, const Chunk& b) {
+        Chunk result;
+        result.high = a.high;
+        if (a.isBitset() && b.isBitset()) {
+            result.bits.resize(BITSET_WORDS);
+            for (size_t w = 0; w < BITSET_WORDS; w++) {
+                result.bits[w] = a.bits[w] & b.bits[w];
+                result.count += __builtin_popcountll(result.bits[w]);
+            }
+        }
+        else if (!a.isBitset() && !b.isBitset()) {
+            set_intersection(a.rows.begin(), a.rows.end(), b.rows.begin(), b.rows.end(), back_inserter(result.rows));
+            result.count = result.rows.size();
+        }
+        else {
+            // Probe the bitset for every row of the array
+            const Chunk& array = a.isBitset() ? b : a;
+            const Chunk& bitset = a.isBitset() ? a : b;
+            copy_if(array.rows.begin(), array.rows.end(), back_inserter(result.rows),
+                    [&bitset](uint16_t low) { return bitset.contains(low); });
+            result.count = result.rows.size();
+        }
+        normalize(result);
+        return result;
+    }
+
+    // Rows in either chunk
+    static Chunk unite(const Chunk& a, const Chunk& b) {
+        Chunk result;
+        result.high = a.high;
+        if (!a.isBitset() && !b.isBitset() && a.count + b.count <= ARRAY_LIMIT) {
+            set_union(a.rows.begin(), a.rows.end(), b.rows.begin(), b.rows.end(), back_inserter(result.rows));
+            result.count = result.rows.size();
+            return result;
+        }
+        result.bits.assign(BITSET_WORDS, 0);
+        for (const Chunk* chunk : {&a, &b}) {
+            if (chunk->isBitset()) {
+                for (size_t w = 0; w < BITSET_WORDS; w++) {
+                    result.bits[w] |= chunk->bits[w];
+                }
+            }
+            else {
+                for (uint16_t low : chunk->rows) {
+                    result.bits[low >> 6] |= 1ull << (low & 63);
+                }
+            }
+        }
+        for (uint64_t word : result.bits) {
+            result.count += __builtin_popcountll(word);
+        }
+        normalize(result);
+        return result;
+    }
+
+public:
+    /**
+     * Adds a row
+     * @pre row is larger than every row added before
+     */
+    void add(size_t row) {
+        uint64_t high = row >> 16;
+        if (chunks.empty() || chunks.back().high != high) {
+            chunks.emplace_back();
+            chunks.back().high = high;
+        }
+        Chunk& chunk = chunks.back();
+        uint16_t low = row & 0xffff;
+        if (chunk.isBitset()) {
+            chunk.bits[low >> 6] |= 1ull << (low & 63);
+        }
+        else {
+            chunk.rows.push_back(low);
+        }
+        chunk.count++;
+        if (chunk.count == ARRAY_LIMIT + 1) {
+            normalize(chunk);
+        }
+    }
+
+    // Rows in both bitmaps; only chunks present in both are looked at
+    RowBitmap intersect(const RowBitmap& other) const {
+        RowBitmap result;
+        for (size_t a = 0, b = 0; a < chunks.size() && b < other.chunks.size(); ) {
+            if (chunks[a].high < other.chunks[b].high) {
+                a++;
+            }
+            else if (chunks[a].high > other.chunks[b].high) {
+                b++;
+            }
+            else {
+                Chunk chunk = intersect(chunks[a++], other.chunks[b++]);
+                if (chunk.count > 0) {
+                    result.chunks.push_back(move(chunk));
+                }
+            }
+        }
+        return result;
+    }
+
+    // Rows in either bitmap
+    RowBitmap unite(const RowBitmap& other) const {
+        RowBitmap result;
+        size_t a = 0, b = 0;
+        while (a < chunks.size() || b < other.chunks.size()) {
+            if (b == other.chunks.size() || (a < chunks.size() && chunks[a].high < other.chunks[b].high)) {
+                result.chunks.push_back(chunks[a++]);
+            }
+            else if (a == chunks.size() || chunks[a].high > other.chunks[b].high) {
+                result.chunks.push_back(other.chunks[b++]);
+            }
+            else {
+                result.chunks.push_back(unite(chunks[a++], other.chunks[b++]));
+            }
+        }
+        return result;
+    }
+
+    // Number of rows in the set
+    size_t count() const {
+        size_t total = 0;
+        for (const Chunk& chunk : chunks) {
+            total += chunk.count;
+        }
+        return total;
+    }
+
+    // Number of chunks, which can be visited on separate threads
+    size_t chunkCount() const { return chunks.size(); }
+
+    /**
+     * Calls visit(begin, end) for every run of consecutive rows in one chunk, in row order
+     * @param c Chunk number, below chunkCount()
+     */
+    template <typename Visitor>
+    void forEachRun(size_t c, const Visitor& visit) const {
+        const Chunk& chunk = chunks[c];
+        size_t base = chunk.high << 16;
+        size_t runBegin = 0, runEnd = 0; // Run waiting to be visited, empty at first
+        auto extend = [&](size_t begin, size_t end) {
+            if (begin != runEnd) {
+                if (runEnd > runBegin) {
+                    visit(runBegin, runEnd);
+                }
+                runBegin = begin;
+            }
+            runEnd = end;
+        };
+        if (chunk.isBitset()) {
+            for (size_t w = 0; w < BITSET_WORDS; w++) {
+                uint64_t word = chunk.bits[w];
+                while (word != 0) {
+                    int start = __builtin_ctzll(word);
+                    uint64_t rest = ~(word >> start);
+                    int length = rest == 0 ? 64 - start : __builtin_ctzll(rest);
+                    extend(base + w * 64 + start, base + w * 64 + start + length);
+                    word = start + length == 64 ? 0 : word & (~0ull << (start + length));
+                }
+            }
+        }
+        else {
+            for (uint16_t low : chunk.rows) {
+                extend(base + low, base + low + 1);
+            }
+        }
+        if (runEnd > runBegin) {
+            visit(runBegin, runEnd);
+        }
+    }
+
+    // Bytes used by the chunks
+    size_t memoryUsage() const {
+        size_t bytes = chunks.capacity() * sizeof(Chunk);
+        for (const Chunk& chunk : chunks) {
+            bytes += chunk.rows.capacity() * sizeof(uint16_t) + chunk.bits.capacity() * sizeof(uint64_t);
+        }
+        return bytes;
+    }
+};
+
+// Class that holds a RowBitmap of the rows of every neighborhood, month and camera,
+// so filters on those columns combine bitmaps instead of scanning the table
+class BitmapIndex {
+private:
+    vector<RowBitmap> neighborhoods; // By neighborhood id
+    vector<RowBitmap> months;        // By the 4 month bits of a packed date, as MonthTotals; 0 for rows without a date
+    vector<RowBitmap> cameras;       // By camera id
+    bool built = false;
+
+public:
+    /**
+     * Builds the bitmaps of a table, one column per thread
+     * @param threads Number of threads
+     */
+    void build(const CameraTable& cameraTable, int threads) {
+        ScopedTimer timer("bitmap index build", cameraTable.size());
+        const vector<uint32_t>& dates = cameraTable.getDateColumn();
+        size_t rows = cameraTable.size();
+        parallelFor(3, threads, [&](size_t column) {
+            if (column == 0) {
+                const vector<int32_t>& ids = cameraTable.getNeighColumn();
+                neighborhoods.assign(cameraTable.getNeighCount(), RowBitmap());
+                for (size_t i = 0; i < rows; i++) {
+                    neighborhoods[ids[i]].add(i);
+                }
+            }
+            else if (column == 1) {
+                months.assign(16, RowBitmap());
+                for (size_t i = 0; i < rows; i++) {
+                    months[dateMonth(dates[i])].add(i);
+                }
+            }
+            else {
+                const vector<int32_t>& ids = cameraTable.getCamColumn();
+                cameras.assign(cameraTable.getCamCount(), RowBitmap());
+                for (size_t i = 0; i < rows; i++) {
+                    cameras[ids[i]].add(i);
+                }
+            }
+        });
+        built = true;
+    }
+
+    bool isBuilt() const { return built; }
+
+    // Rows of one neighborhood id, month number (1-12) or camera id
+    const RowBitmap& getNeighborhoodRows(int32_t id) const { return neighborhoods[id]; }
+    const RowBitmap& getMonthRows(int month) const { return months[month]; }
+    const RowBitmap& getCameraRows(int32_t id) const { return cameras[id]; }
+
+    // Bytes used by every bitmap
+    size_t memoryUsage() const {
+        size_t bytes = 0;
+        for (const vector<RowBitmap>* column : {&neighborhoods, &months, &cameras}) {
+            for (const RowBitmap& bitmap : *column) {
+                bytes += bitmap.memoryUsage();
+            }
+        }
+        return bytes;
+    }
+};
+
+// A row filter such as "neighborhood=Lincoln Park and month=7 or camera=1413",
+// parsed by parseFilter(): "and" binds tighter than "or", as in SQL
+struct RowFilter {
+    string text;
+    vector<vector<pair<string, string>>> anyOf; // Groups of (column, value) terms that must all match
+};
+
+// Aggregates of the rows a filter selected, for the overview, neighborhood, month and region reports
+struct FilteredAggregates {
+    OverviewStats overview;
+    GroupAggregator neighborhoods;
+    GroupAggregator regions;
+    MonthTotals months;
+};
+
+// How reports are written
+// TEXT_FORMAT is the menu's console layout; the others are for scripts:
+// - TSV_FORMAT: a "# <report>" line, a header row, then one tab-separated row per result
+// - CSV_FORMAT: a header row, then one row per result; reports are separated by an empty line
+// - JSON_FORMAT: one JSON object per report and line, {"report": ..., "rows": [{column: value, ...}, ...]}
+enum OutputFormat { TEXT_FORMAT, TSV_FORMAT, CSV_FORMAT, JSON_FORMAT };
+
+// Class that collects report output in one buffer that is reused by every report
+// Numbers are formatted with to_chars and padding is written directly, so no
+// stream state or temporary strings are involved; flush() hands the text to
+// cout (or, in server mode, a client's socket) in one write
+class OutputBuffer {
+private:
+    string buffer;
+    int socket; // Client socket the output goes to, or -1 for cout
+    static const size_t SPILL_BYTES = 1 << 16; // Larger output goes out in blocks of this size
+    static thread_local OutputBuffer* current; // Set by redirect()
+
+    // Hands the buffered bytes to cout or the socket
+    void write() {
+        if (socket < 0) {
+            cout.write(buffer.data(), buffer.size());
+        }
+        else {
+            // A client that went away is dropped silently (MSG_NOSIGNAL avoids SIGPIPE)
+            for (size_t sent = 0; sent < buffer.size();) {
+                ssize_t count = send(socket, buffer.data() + sent, buffer.size() - sent, MSG_NOSIGNAL);
+                if (count <= 0) {
+                    break;
+                }
+                sent += count;
+            }
+        }
+        buffer.clear();
+    }
+
+    // Writes a full buffer out so very long reports use bounded memory
+    void spill() {
+        if (buffer.size() >= SPILL_BYTES) {
+            write();
+        }
+    }
+
+public:
+    // Constructor
+    explicit OutputBuffer(int socket = -1) : socket(socket) {}
+
+    // The buffer reports on this thread write to: cout unless redirect() gave another one
+    static OutputBuffer& standard() {
+        static OutputBuffer output;
+        return current != nullptr ? *current : output;
+    }
+
+    // Sends the reports of this thread to output until the next call; nullptr goes back to cout
+    static void redirect(OutputBuffer* output) {
+        current = output;
+    }
+
+    OutputBuffer& operator<<(string_view text) {
+        buffer.append(text);
+        spill();
+        return *this;
+    }
+    OutputBuffer& operator<<(const char* text) { return *this << string_view(text); }
+    OutputBuffer& operator<<(const string& text) { return *this << string_view(text); }
+    OutputBuffer& operator<<(char c) {
+        buffer.push_back(c);
+        return *this;
+    }
+
+    // Writes any integer
+    template <typename Integer>
+    OutputBuffer& operator<<(Integer value) {
+        static_assert(is_integral<Integer>::value, "only integers are formatted");
+        char digits[24];
+        char* end = to_chars(digits, digits + sizeof(digits), value).ptr;
+        buffer.append(digits, end);
+        return *this;
+    }
+
+    // Writes a character count times
+    OutputBuffer& repeat(char c, size_t count) {
+        buffer.append(count, c);
+        spill();
+        return *this;
+    }
+
+    // Writes text left-aligned in a field of width characters, like left << setw(width)
+    OutputBuffer& padRight(string_view text, size_t width) {
+        *this << text;
+        return repeat(' ', text.size() < width ? width - text.size() : 0);
+    }
+
+    // Writes an integer right-aligned in a field of width characters, like right << setw(width)
+    template <typename Integer>
+    OutputBuffer& padLeft(Integer value, size_t width) {
+        char digits[24];
+        size_t length = to_chars(digits, digits + sizeof(digits), value).ptr - digits;
+        repeat(' ', length < width ? width - length : 0);
+        buffer.append(digits, length);
+        return *this;
+    }
+
+    // Writes an integer with leading zeros up to width digits, like setfill('0') << setw(width)
+    OutputBuffer& zeroPadded(int value, size_t width) {
+        char digits[24];
+        size_t length = to_chars(digits, digits + sizeof(digits), value).ptr - digits;
+        repeat('0', length < width ? width - length : 0);
+        buffer.append(digits, length);
+        return *this;
+    }
+
+    // Hands everything written so far to cout or the socket and flushes it
+    void flush() {
+        write();
+        if (socket < 0) {
+            cout.flush();
+        }
+    }
+};
+
+thread_local OutputBuffer* OutputBuffer::current = nullptr;
+
+// Class that writes the result rows of one report as TSV, CSV or JSON into an OutputBuffer
+// Fields are given in column order with field() and each row is closed with endRow()
+class TableEmitter {
+private:
+    OutputBuffer& out;
+    OutputFormat format;
+    vector<const char*> columns;
+    size_t column;  // Next column of the current row
+    bool firstRow;
+
+    // Writes text as the body of a JSON string
+    void jsonText(string_view text) {
+        for (char c : text) {
+            if (c == '"' || c == '\\') {
+                out << '\\' << c;
+            }
+            else if ((unsigned char)c < 0x20) {
+                out << "\\u00" << "0123456789abcdef"[c >> 4] << "0123456789abcdef"[c & 15];
+            }
+            else {
+                out << c;
+            }
+        }
+    }
+
+    // Writes what comes before a field: a separator, or the opening of a JSON row and the key
+    void startField() {
+        if (format == JSON_FORMAT) {
+            out << (column == 0 ? (firstRow ? "{\"" : ",{\"") : ",\"") << columns[column] << "\":";
+        }
+        else if (column > 0) {
+            out << (format == TSV_FORMAT ? '\t' : ',');
+        }
+        column++;
+    }
+
+public:
+    /**
+     * Starts a report and writes its header
+     * @param out Buffer to write to
+     * @param format TSV_FORMAT, CSV_FORMAT or JSON_FORMAT
+     * @param report Report name
+     * @param columns Column names, in the order fields are given
+     * @param paramName Name of a report parameter, such as the search term, or nullptr
+     * @param paramValue Value of the parameter
+     */
+    TableEmitter(OutputBuffer& out, OutputFormat format, const char* report, vector<const char*> columns,
+                 const char* paramName = nullptr, string_view paramValue = "")
+        : out(out), format(format), columns(move(columns)), column(0), firstRow(true) {
+        if (format == JSON_FORMAT) {
+            out << "{\"report\":\"" << report << '"';
+            if (paramName != nullptr) {
+                out << ",\"" << paramName << "\":\"";
+                jsonText(paramValue);
+                out << '"';
+            }
+            out << ",\"rows\":[";
+            return;
+        }
+        if (format == TSV_FORMAT) {
+            out << "# " << report;
+            if (paramName != nullptr) {
+                out << '\t';
+                field(paramValue);
+                column = 0;
+            }
+            out << '\n';
+        }
+        for (size_t c = 0; c < this->columns.size(); c++) {
+            out << (c == 0 ? "" : format == TSV_FORMAT ? "\t" : ",") << this->columns[c];
+        }
+        out << '\n';
+    }
+
+    // Adds a text field; TSV replaces tabs and line breaks with spaces, CSV quotes when needed
+    void field(string_view text) {
+        startField();
+        if (format == JSON_FORMAT) {
+            out << '"';
+            jsonText(text);
+            out << '"';
+        }
+        else if (format == CSV_FORMAT && text.find_first_of(",\"\r\n") != string_view::npos) {
+            out << '"';
+            for (char c : text) {
+                out << c;
+                if (c == '"') {
+                    out << '"';
+                }
+            }
+            out << '"';
+        }
+        else if (format == TSV_FORMAT) {
+            for (char c : text) {
+                out << (c == '\t' || c == '\n' || c == '\r' ? ' ' : c);
+            }
+        }
+        else {
+            out << text;
+        }
+    }
+
+    // Adds an integer field
+    template <typename Integer, typename = enable_if_t<is_integral_v<Integer>>>
+    void field(Integer value) {
+        startField();
+        out << value;
+    }
+
+    // Ends the current row
+    void endRow() {
+        out << (format == JSON_FORMAT ? '}' : '\n');
+        column = 0;
+        firstRow = false;
+    }
+
+    // Ends the report
+    void finish() {
+        if (format == JSON_FORMAT) {
+            out << "]}\n";
+        }
+        else if (format == CSV_FORMAT) {
+            out << '\n';
+        }
+    }
+};
+
+// Class that passes blocks of bytes from one thread to another, like a pipe
+// At most capacity blocks wait at a time, so a fast producer cannot fill the memory
+class BlockQueue {
+private:
+    mutex lock;
+    condition_variable changed;
+    deque<string> blocks;
+    size_t capacity;
+    bool closed;
+
+public:
+    // Constructor
+    explicit BlockQueue(size_t capacity) : capacity(capacity), closed(false) {}
+
+    // Adds a block, waiting while the queue is full
+    void push(string block) {
+        unique_lock<mutex> guard(lock);
+        changed.wait(guard, [this]() { return blocks.size() < capacity; });
+        blocks.push_back(move(block));
+        changed.notify_all();
+    }
+
+    // Tells the consumer no more blocks will come
+    void close() {
+        lock_guard<mutex> guard(lock);
+        closed = true;
+        changed.notify_all();
+    }
+
+    /**
+     * Takes the oldest block, waiting until one is there
+     * @param block Receives the block
+     * @return false once the queue is closed and empty
+     */
+    bool pop(string& block) {
+        unique_lock<mutex> guard(lock);
+        changed.wait(guard, [this]() { return !blocks.empty() || closed; });
+        if (blocks.empty()) {
+            return false;
+        }
+        block = move(blocks.front());
+        blocks.pop_front();
+        changed.notify_all();
+        return true;
+    }
+};
+
+// Date range and list length of the query reports (top and yearmonth)
+// Dates are packed (see packDate()) and both ends are included
+struct DateQuery {
+    uint32_t from = 1;          // Rows with an unreadable date (0) are left out
+    uint32_t to = UINT32_MAX;
+    size_t limit = 10;          // Entries in a top list
+};
+
+// Lines a parse set aside instead of loading, counted by reason
+// The lines point into the parsed buffer, so they are only valid while it is
+struct RowErrors {
+    enum Reason { FIELD_COUNT, UNCLOSED_QUOTE, BAD_DATE, BAD_VIOLATIONS, REASONS };
+    array<size_t, REASONS> counts = {};
+    size_t headers = 0;        // Header lines skipped, not counted as errors
+    vector<string_view> lines; // Rejected lines in file order
+
+    void add(Reason reason, string_view line) {
+        counts[reason]++;
+        lines.push_back(line);
+    }
+
+    // Appends the errors of the next part of the same buffer
+    void merge(const RowErrors& other) {
+        for (int r = 0; r < REASONS; r++) {
+            counts[r] += other.counts[r];
+        }
+        headers += other.headers;
+        lines.insert(lines.end(), other.lines.begin(), other.lines.end());
+    }
+
+    size_t total() const {
+        return lines.size();
+    }
+
+    // Such as "3 malformed rows (2 with a wrong field count, 1 with a bad date)"
+    string summary() const {
+        static const char* const names[REASONS] = {"a wrong field count", "an unclosed quote", "a bad date", "a bad violation count"};
+        string text = to_string(total()) + " malformed row" + (total() == 1 ? "" : "s") + " (";
+        bool first = true;
+        for (int r = 0; r < REASONS; r++) {
+            if (counts[r] > 0) {
+                text += (first ? "" : ", ") + to_string(counts[r]) + " with " + names[r];
+                first = false;
+            }
+        }
+        return text + ")";
+    }
+};
+
+// Data the query server answers from, loaded once and then only read
+// Client threads each hold a shared_ptr to it, so it lives until the last of them finishes
+struct ServerData {
+    CameraTable cameraTable;
+    RollupCube rollup;
+    SearchIndex searchIndex;
+};
+
+// Function prototypes
+void dumpProfile();
+int splitQuotedFields(string_view line, string_view fields[6], string unquoted[6]);
+bool isHeaderRow(const string_view fields[6]);
+void parseRange(const char* begin, const char* end, CameraTable& cameraTable, RowErrors& errors);
+size_t estimateRows(const char* begin, const char* end);
+void parseBuffer(const char* begin, const char* end, const string& region, int threads,
+                 CameraTable& cameraTable, RowErrors& errors);
+const char* decompressCommand(const char* begin, const char* end);
+bool parseCompressed(const string& fileName, const char* command, const string& region,
+                     CameraTable& cameraTable, RowErrors& errors, deque<string>& rejectedLines);
+CameraTable readFile(string fileName, int threads, bool useSnapshot, RollupCube* rollup = nullptr,
+                     bool* loaded = nullptr);
+string regionName(const string& fileName);
+vector<string> expandInputs(const vector<string>& inputs);
+CameraTable readFiles(const vector<string>& fileNames, int threads, bool useSnapshot, RollupCube* rollup = nullptr,
+                      bool* loaded = nullptr);
+void benchmarkIngest(string fileName, int copies);
+CameraTable makeSyntheticTable(size_t rows, int cameras);
+void benchmarkAggregation(const vector<size_t>& rowCounts);
+int runBatch(const vector<string>& fileNames, const vector<pair<string, string>>& reports,
+             OutputFormat format, int threads, bool useSnapshot, bool useIndex, bool approximate,
+             const DateQuery& query, const RowFilter* filter);
+bool parseFilter(const string& text, RowFilter& filter, string& error);
+bool parseCount(string_view text, long long minimum, long long maximum, long long& value);
+bool filterRows(const CameraTable& cameraTable, const BitmapIndex& bitmapIndex, const RowFilter& filter,
+                RowBitmap& rows, string& error);
+FilteredAggregates aggregateRows(const CameraTable& cameraTable, const RowBitmap& rows, int threads);
+void dataOverview(const CameraTable& cameraTable, const RollupCube& rollup, OutputFormat format = TEXT_FORMAT,
+                  const CameraSketches* sketches = nullptr);
+void printOverview(const CameraTable& cameraTable, const OverviewStats& stats, OutputFormat format,
+                   const CameraSketches* sketches = nullptr);
+void resultsByNeighborhood(const CameraTable& cameraTable, const RollupCube& rollup, OutputFormat format = TEXT_FORMAT,
+                           const CameraSketches* sketches = nullptr);
+void printNeighborhoods(const CameraTable& cameraTable, const GroupAggregator& groups, OutputFormat format,
+                        const CameraSketches* sketches = nullptr);
+void displayChartByMonth(const CameraTable& cameraTable, const RollupCube& rollup, OutputFormat format = TEXT_FORMAT);
+void printMonthChart(const MonthTotals& months, OutputFormat format);
+int followFile(const string& fileName, const vector<pair<string, string>>& reports,
+               OutputFormat format, int threads, int intervalMs);
+int serveQueries(const vector<string>& fileNames, const string& socketPath, OutputFormat format,
+                 int threads, bool useSnapshot);
+bool answerQuery(const string& request, const CameraTable& cameraTable, const RollupCube& rollup,
+                 const SearchIndex& searchIndex, OutputFormat format);
+void benchmarkServer(const string& socketPath, const vector<string>& requests, int clients, int repeats);
+GroupAggregator groupByColumn(const CameraTable& cameraTable, const vector<int32_t>& keys, int threads);
+vector<int32_t> sortByViolations(const GroupAggregator& groups);
+void resultsByRegion(const CameraTable& cameraTable, int threads, OutputFormat format = TEXT_FORMAT);
+void printRegions(const CameraTable& cameraTable, const GroupAggregator& groups, OutputFormat format);
+string getMonth(int monthNumber);
+vector<pair<int32_t, int64_t>> topTotals(const vector<int64_t>& totals, size_t k);
+vector<int64_t> cameraTotalsInRange(const RollupCube& rollup, int32_t cameraCount, uint32_t from, uint32_t to);
+vector<int64_t> columnTotalsInRange(const CameraTable& cameraTable, const DateIndex& dateIndex,
+                                    const vector<int32_t>& keys, int32_t keyCount, uint32_t from, uint32_t to);
+vector<pair<uint32_t, int64_t>> topDaysInRange(const DateIndex& dateIndex, uint32_t from, uint32_t to, size_t k);
+vector<pair<uint32_t, int64_t>> yearMonthTotalsInRange(const DateIndex& dateIndex, uint32_t from, uint32_t to);
+string isoDate(uint32_t date);
+void displayTop(const CameraTable& cameraTable, const RollupCube& rollup, const DateIndex& dateIndex,
+                const string& kind, const DateQuery& query, OutputFormat format);
+void displayYearMonths(const DateIndex& dateIndex, const DateQuery& query, OutputFormat format);
+void searchByCamera(const CameraTable& cameraTable, const SearchIndex& searchIndex);
+void displaySearchResults(const CameraTable& cameraTable, const SearchIndex& searchIndex,
+                          string searchTerm, OutputFormat format);
+vector<size_t> scanSearch(const CameraTable& cameraTable, const string& searchTerm);
+bool containsIgnoreCase(string_view text, string_view lowerTerm);
+bool containsIgnoreCaseScalar(string_view text, string_view lowerTerm);
+void benchmarkSearch(const string& searchTerm, const vector<string>& fileNames, int threads);
+bool generateData(size_t rows, const string& outName, const vector<string>& seedFiles, uint64_t seed, int threads);
+void benchmarkSuite(const vector<size_t>& rowCounts, const vector<string>& seedFiles, int threads, int repeats);
+
+
+int main(int argc, char* argv[]) {
+    int choice;
+    string fileName;
+    int threads = 0; // Parser threads, 0 uses every hardware thread
+    bool useSnapshot = true; // Load and save <file>.snap binary snapshots
+    bool useIndex = true;    // Build the trigram search index after loading
+    bool approximate = false; // Answer camera counts and busiest intersections from sketches
+    vector<string> fileNames;  // Batch mode: files to load (--file)
+    vector<pair<string, string>> reports; // Batch mode: (report name, search term or top kind) in the order given
+    OutputFormat format = TEXT_FORMAT;    // Batch mode output format
+    DateQuery query;                      // Batch mode: range and length of the query reports
+    RowFilter filter;                     // Batch mode: rows the aggregation reports cover (--where)
+    string followName;     // Follow mode: file watched for appended rows (--follow)
+    string socketPath;     // Server mode: Unix socket queries are answered on (--serve)
+    int intervalMs = 1000; // Follow mode: milliseconds between checks (--interval)
+
+    // Options come first; anything after them selects a benchmark
+    int arg = 1;
+    for (; arg < argc; arg++) {
+        string option = argv[arg];
+        bool hasValue = arg + 1 < argc;
+        if (option == "--threads" && hasValue) {
+            long long value;
+            if (!parseCount(argv[++arg], 1, numeric_limits<int>::max(), value)) {
+                cerr << "Invalid thread count: " << argv[arg] << " (expected a whole number of at least 1)" << endl;
+                return 1;
+            }
+            threads = value;
+        }
+        else if (option == "--no-snapshot") {
+            useSnapshot = false;
+        }
+        else if (option == "--no-index") {
+            useIndex = false;
+        }
+        else if (option == "--approx") {
+            approximate = true;
+        }
+        else if (option == "--profile") {
+            Profiler::instance().enable();
+        }
+        else if (option == "--file" && hasValue) {
+            fileNames.push_back(argv[++arg]);
+        }
+        else if (option == "--report" && hasValue) {
+            string report = argv[++arg];
+            if (report != "overview" && report != "neighborhood" && report != "month" && report != "region"
+                && report != "yearmonth") {
+                cerr << "Unknown report: " << report << " (expected overview, neighborhood, month, region or yearmonth)" << endl;
+                return 1;
+            }
+            reports.push_back(make_pair(report, ""));
+        }
+        else if (option == "--top" && hasValue) {
+            string kind = argv[++arg];
+            if (kind != "cameras" && kind != "intersections" && kind != "days") {
+                cerr << "Unknown top list: " << kind << " (expected cameras, intersections or days)" << endl;
+                return 1;
+            }
+            reports.push_back(make_pair("top", kind));
+        }
+        else if ((option == "--from" || option == "--to") && hasValue) {
+            uint32_t date = parseDate(argv[++arg]);
+            if (date == 0) {
+                cerr << "Invalid date: " << argv[arg] << " (expected YYYY-MM-DD)" << endl;
+                return 1;
+            }
+            (option == "--from" ? query.from : query.to) = date;
+        }
+        else if (option == "--limit" && hasValue) {
+            long long value;
+            if (!parseCount(argv[++arg], 1, numeric_limits<int>::max(), value)) {
+                cerr << "Invalid limit: " << argv[arg] << " (expected a whole number of at least 1)" << endl;
+                return 1;
+            }
+            query.limit = value;
+        }
+        else if (option == "--where" && hasValue) {
+            string error;
+            if (!parseFilter(argv[++arg], filter, error)) {
+                cerr << "Invalid filter: " << error << endl;
+                return 1;
+            }
+        }
+        else if (option == "--search" && hasValue) {
+            reports.push_back(make_pair("search", argv[++arg]));
+        }
+        else if (option == "--follow" && hasValue) {
+            followName = argv[++arg];
+        }
+        else if (option == "--interval" && hasValue) {
+            long long value;
+            if (!parseCount(argv[++arg], 1, numeric_limits<int>::max(), value)) {
+                cerr << "Invalid interval: " << argv[arg] << " (expected milliseconds, at least 1)" << endl;
+                return 1;
+            }
+            intervalMs = value;
+        }
+        else if (option == "--serve" && hasValue) {
+            socketPath = argv[++arg];
+        }
+        else if (option == "--format" && hasValue) {
+            string name = argv[++arg];
+            if (name == "text") {
+                format = TEXT_FORMAT;
+            }
+            else if (name == "tsv") {
+                format = TSV_FORMAT;
+            }
+            else if (name == "csv") {
+                format = CSV_FORMAT;
+            }
+            else if (name == "json") {
+                format = JSON_FORMAT;
+            }
+            else {
+                cerr << "Unknown format: " << name << " (expected text, tsv, csv or json)" << endl;
+                return 1;
+            }
+        }
+        else {
+            break;
+        }
+    }
+    argc -= arg - 1;
+    argv += arg - 1;
+
+    // Filters are answered from bitmap indexes that only batch mode builds
+    if (!filter.anyOf.empty() && (fileNames.empty() || !followName.empty() || !socketPath.empty())) {
+        cerr << "--where is only supported in batch mode (--file without --follow or --serve)" << endl;
+        return 1;
+    }
+    // Sketches are built by batch mode and the menu; the server and follow mode answer exactly
+    if (approximate && (!followName.empty() || !socketPath.empty())) {
+        cerr << "--approx is not supported with --follow or --serve" << endl;
+        return 1;
+    }
+
+    // Follow mode: keep the reports up to date as rows are appended to one file
+    if (!followName.empty()) {
+        // Only these aggregates are kept up to date as rows arrive
+        for (const pair<string, string>& report : reports) {
+            if (report.first != "overview" && report.first != "neighborhood" && report.first != "month") {
+                string given = report.first == "top" ? "--top " + report.second
+                               : report.first == "search" ? "--search" : "--report " + report.first;
+                cerr << given << " is not supported with --follow (expected the overview, neighborhood or month report)" << endl;
+                return 1;
+            }
+        }
+        if (reports.empty()) {
+            reports.push_back(make_pair("overview", ""));
+        }
+        return followFile(followName, reports, format, threads, intervalMs);
+    }
+
+    // Server mode: load every --file once and answer queries from other processes
+    if (!socketPath.empty()) {
+        if (fileNames.empty()) {
+            cerr << "--serve needs at least one --file" << endl;
+            return 1;
+        }
+        return serveQueries(fileNames, socketPath, format, threads, useSnapshot);
+    }
+
+    // Batch mode: load every --file once and run every report without prompting
+    if (!fileNames.empty()) {
+        return runBatch(fileNames, reports, format, threads, useSnapshot, useIndex, approximate, query,
+                        filter.anyOf.empty() ? nullptr : &filter);
+    }
+
+    // Benchmark counts are checked like option values; every one must be at least 1
+    const long long maxCount = numeric_limits<long long>::max();
+    long long value;
+    // Ingest benchmark: ./main --bench-ingest <file> [copies]
+    if (argc >= 3 && string(argv[1]) == "--bench-ingest") {
+        value = 100;
+        if (argc >= 4 && !parseCount(argv[3], 1, numeric_limits<int>::max(), value)) {
+            cerr << "Invalid copy count: " << argv[3] << " (expected a whole number of at least 1)" << endl;
+            return 1;
+        }
+        benchmarkIngest(argv[2], value);
+        return 0;
+    }
+    // Aggregation benchmark: ./main --bench-aggregate [rows...]
+    if (argc >= 2 && string(argv[1]) == "--bench-aggregate") {
+        vector<size_t> rowCounts;
+        for (int i = 2; i < argc; i++) {
+            if (!parseCount(argv[i], 1, maxCount, value)) {
+                cerr << "Invalid row count: " << argv[i] << " (expected a whole number of at least 1)" << endl;
+                return 1;
+            }
+            rowCounts.push_back(value);
+        }
+        if (rowCounts.empty()) {
+            rowCounts = {10000, 1000000, 100000000};
+        }
+        benchmarkAggregation(rowCounts);
+        return 0;
+    }
+    // Search benchmark: ./main --bench-search <term> <file>...
+    if (argc >= 4 && string(argv[1]) == "--bench-search") {
+        benchmarkSearch(argv[2], vector<string>(argv + 3, argv + argc), threads);
+        return 0;
+    }
+    // Server latency benchmark: ./main --bench-server <socket> [clients] [requests per client]
+    if (argc >= 3 && string(argv[1]) == "--bench-server") {
+        long long clients = 4, requests = 1000;
+        if ((argc >= 4 && !parseCount(argv[3], 1, numeric_limits<int>::max(), clients))
+            || (argc >= 5 && !parseCount(argv[4], 1, numeric_limits<int>::max(), requests))) {
+            cerr << "Invalid client or request count (expected whole numbers of at least 1)" << endl;
+            return 1;
+        }
+        benchmarkServer(argv[2], {"overview", "neighborhood", "month", "search lake"}, clients, requests);
+        return 0;
+    }
+    // Data generator: ./main --generate <rows> <output> <seed file>...
+    if (argc >= 5 && string(argv[1]) == "--generate") {
+        if (!parseCount(argv[2], 1, maxCount, value)) {
+            cerr << "Invalid row count: " << argv[2] << " (expected a whole number of at least 1)" << endl;
+            return 1;
+        }
+        vector<string> seedFiles = expandInputs(vector<string>(argv + 4, argv + argc));
+        return generateData(value, argv[3], seedFiles, 42, threads) ? 0 : 1;
+    }
+    // Benchmark suite with JSON results: ./main --bench-suite <rows>[,<rows>...] <seed file>...
+    if (argc >= 4 && string(argv[1]) == "--bench-suite") {
+        vector<size_t> rowCounts;
+        for (size_t start = 0, comma; start <= strlen(argv[2]); start = comma + 1) {
+            comma = string(argv[2]).find(',', start);
+            comma = comma == string::npos ? strlen(argv[2]) : comma;
+            if (!parseCount(string_view(argv[2]).substr(start, comma - start), 1, maxCount, value)) {
+                cerr << "Invalid row counts: " << argv[2] << " (expected whole numbers of at least 1, separated by commas)" << endl;
+                return 1;
+            }
+            rowCounts.push_back(value);
+        }
+        benchmarkSuite(rowCounts, expandInputs(vector<string>(argv + 3, argv + argc)), threads, 3);
+        return 0;
+    }
+    if (argc >= 2) {
+        cerr << "Unknown option: " << argv[1] << endl;
+        return 1;
+    }
+
+    // Get input file name from user
+    cout << "Enter file to use: " << endl;
+    cin >> fileName;
+    // A directory or pattern such as *-side.txt loads several files into one table
+    vector<string> inputFiles = expandInputs({fileName});
+    if (threads <= 0) {
+        threads = defaultThreads();
+    }
+    RollupCube rollup; // Aggregates the menu reports are answered from
+    CameraTable cameraTable = readFiles(inputFiles, threads, useSnapshot, &rollup); // Read data from file
+    SearchIndex searchIndex; // Built once so every search only checks candidate texts
+    if (useIndex) {
+        searchIndex.build(cameraTable);
+    }
+    CameraSketches sketches;
+    if (approximate) {
+        sketches.build(cameraTable, threads);
+    }
+    dumpProfile();
+
+    // Main menu loop
+    do {
+        cout << "\nSelect a menu option:" << endl;
+        cout << "  1. Data overview" << endl;
+        cout << "  2. Results by neighborhood" << endl;
+        cout << "  3. Chart by month" << endl;
+        cout << "  4. Search for cameras" << endl;
+        cout << "  5. Exit" << endl;
+        cout << "Your choice: ";
+        
+        // Input validation to handle non-numeric input
+        if (!(cin >> choice)) {
+            cin.clear();  // Clear the error flags
+            cin.ignore(numeric_limits<streamsize>::max(), '\n');  // Clear the input buffer
+            cout << "Invalid choice. Please try again." << endl;
+            continue;
+        }
+ 
+        // Process user choice
+        switch(choice){
+            case 1:
+                dataOverview(cameraTable, rollup, TEXT_FORMAT, approximate ? &sketches : nullptr);
+                break;
+            case 2:
+                resultsByNeighborhood(cameraTable, rollup, TEXT_FORMAT, approximate ? &sketches : nullptr);
+                break;
+            case 3:
+                displayChartByMonth(cameraTable, rollup);
+                break;
+            case 4:
+                searchByCamera(cameraTable, searchIndex);
+                break;
+            case 5:
+                break;
+            default:
+                cout << "Invalid choice. Please try again." << endl;
+        }
+        dumpProfile();
+    } while (choice != 5);
+
+    return 0;
+}
+
+/**
+ * Splits a CSV line that holds quotes into its six fields
+ * A field that starts with a quote runs to the matching closing quote and may
+ * hold commas and doubled quotes (""), which stand for one quote character.
+ * An unquoted neighborhood takes the rest of the line, commas and all, like the plain parser
+ * @param line Line without its line break
+ * @param fields Receives the fields; quoted ones point into unquoted
+ * @param unquoted Scratch strings for the text of quoted fields, reused from line to line
+ * @return number of fields, or -1 if a quote is not closed or text follows a closing quote
+ */
+int splitQuotedFields(string_view line, string_view fields[6], string unquoted[6]) {
+    size_t pos = 0;
+    int count = 0;
+    while (true) {
+        bool last = count == 5;
+        if (pos < line.size() && line[pos] == '"') {
+            string& text = unquoted[count];
+            text.clear();
+            for (size_t start = pos + 1; ; ) {
+                size_t quote = line.find('"', start);
+                if (quote == string_view::npos) {
+                    return -1;
+                }
+                text.append(line.data() + start, quote - start);
+                if (quote + 1 < line.size() && line[quote + 1] == '"') {
+                    text.push_back('"');
+                    start = quote + 2;
+                    continue;
+                }
+                pos = quote + 1;
+                break;
+            }
+            fields[count++] = text;
+            if (pos == line.size()) {
+                return count;
+            }
+            if (line[pos] != ',' || last) {
+                return -1;
+            }
+            pos++;
+        }
+        else {
+            size_t comma = last ? string_view::npos : line.find(',', pos);
+            if (comma == string_view::npos) {
+                fields[count++] = line.substr(pos);
+                return count;
+            }
+            fields[count++] = line.substr(pos, comma - pos);
+            pos = comma + 1;
+        }
+    }
+}
+
+/**
+ * Checks whether a row is a header line with the columns of headers.txt
+ * Each field only has to contain the column's key word, ignoring case, so
+ * "Date (formatted year-month-day)" and "VIOLATION DATE" both name the date column
+ */
+bool isHeaderRow(const string_view fields[6]) {
+    static const char* const keyWords[6] = {"intersection", "address", "camera", "date", "violations", "neighborhood"};
+    for (int f = 0; f < 6; f++) {
+        if (!containsIgnoreCase(fields[f], keyWords[f])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * Parses the complete lines in a byte range and appends each row to the table
+ * Lines may end in "\n" or "\r\n" and fields may be quoted (see splitQuotedFields()).
+ * Lines without quotes, which is nearly all of them, are split with memchr alone.
+ * Header lines are skipped. A line without six fields, a camera number, a valid
+ * date and a whole violation count is not loaded but recorded in errors
+ * @param begin First byte of the range, at the start of a line
+ * @param end One past the last byte of the range, at the end of a line or of the file
+ * @param cameraTable Table receiving the rows
+ * @param errors Receives the lines that were set aside
+ */
+void parseRange(const char* begin, const char* end, CameraTable& cameraTable, RowErrors& errors) {
+    const char* pos = begin;
+    string unquoted[6]; // Text of quoted fields, reused by every line
+
+    // Walk the buffer one line at a time until the end of the range
+    while (pos < end) {
+        const char* lineEnd = static_cast<const char*>(memchr(pos, '\n', end - pos));
+        if (lineEnd == nullptr) {
+            lineEnd = end; // Last line without a trailing newline
+        }
+        string_view line(pos, lineEnd - pos);
+        pos = lineEnd + 1;
+        if (!line.empty() && line.back() == '\r') {
+            line.remove_suffix(1);
+        }
+
+        // Skip blank lines, such as the one after the final newline
+        if (line.empty()) {
+            continue;
+        }
+
+        string_view fields[6];
+        int fieldCount = 0;
+        if (memchr(line.data(), '"', line.size()) == nullptr) {
+            // Split the first five fields on commas; the rest of the line is the neighborhood
+            const char* fieldStart = line.data();
+            const char* fieldsEnd = line.data() + line.size();
+            while (fieldCount < 5) {
+                const char* comma = static_cast<const char*>(memchr(fieldStart, ',', fieldsEnd - fieldStart));
+                if (comma == nullptr) {
+                    break;
+                }
+                fields[fieldCount++] = string_view(fieldStart, comma - fieldStart);
+                fieldStart = comma + 1;
+            }
+            fields[fieldCount++] = string_view(fieldStart, fieldsEnd - fieldStart);
+        }
+        else {
+            fieldCount = splitQuotedFields(line, fields, unquoted);
+            if (fieldCount < 0) {
+                errors.add(RowErrors::UNCLOSED_QUOTE, line);
+                continue;
+            }
+        }
+        if (fieldCount != 6 || fields[2].empty()) {
+            errors.add(RowErrors::FIELD_COUNT, line);
+            continue;
+        }
+
+        // Convert violations to an integer without building a temporary string;
+        // unsigned digit values above 9 mean the character was not a digit
+        unsigned violations = 0;
+        bool digits = !fields[4].empty() && fields[4].size() <= 9;
+        for (char c : fields[4]) {
+            unsigned digit = (unsigned char)c - '0';
+            digits &= digit <= 9;
+            violations = violations * 10 + digit;
+        }
+        uint32_t date = parseDate(fields[3]);
+
+        // A header has words where the numbers should be, so it is only looked for here
+        if (!digits || date == 0) {
+            if (isHeaderRow(fields)) {
+                errors.headers++;
+            }
+            else {
+                errors.add(date == 0 ? RowErrors::BAD_DATE : RowErrors::BAD_VIOLATIONS, line);
+            }
+            continue;
+        }
+
+        cameraTable.addRecord(fields[0], fields[1], fields[2], date, violations, fields[5]);
+    }
+}
+
+/**
+ * Guesses how many lines a buffer holds from the line length at its start,
+ * so columns can be sized once instead of doubling (and copying) as rows arrive
+ * @param begin First byte of the buffer
+ * @param end One past the last byte of the buffer
+ * @return estimated number of lines, rounded up by 1/16 so a small error still fits
+ */
+size_t estimateRows(const char* begin, const char* end) {
+    size_t bytes = end - begin;
+    size_t sampleBytes = min<size_t>(bytes, 64 * 1024);
+    size_t lines = count(begin, begin + sampleBytes, '\n');
+    if (lines == 0) {
+        return 1;
+    }
+    size_t rows = bytes / sampleBytes * lines + (bytes % sampleBytes) * lines / sampleBytes;
+    return rows + rows / 16;
+}
+
+/**
+ * Parses a buffer of complete lines and appends the rows to a table
+ * An empty table's columns are sized from estimateRows() first
+ * Buffers of more than 1 MB are cut into byte ranges that end on a newline,
+ * the ranges are parsed on separate threads and the results are joined in order
+ * @param begin First byte of the buffer
+ * @param end One past the last byte of the buffer
+ * @param region Region given to every new row
+ * @param threads Number of threads to parse with
+ * @param cameraTable Table receiving the rows
+ * @param errors Receives the lines that were set aside, in buffer order
+ */
+void parseBuffer(const char* begin, const char* end, const string& region, int threads,
+                 CameraTable& cameraTable, RowErrors& errors) {
+    ScopedTimer timer("parse", 0, end - begin);
+    size_t rowsBefore = cameraTable.size();
+    cameraTable.setRegion(region);
+
+    // Small buffers are not worth splitting
+    const size_t minChunkBytes = 1 << 20;
+    size_t bytes = end - begin;
+    size_t chunkCount = min((size_t)threads * 4, bytes / minChunkBytes);
+    if (threads == 1 || chunkCount <= 1) {
+        // Tables that already hold rows grow normally, so repeated small appends stay amortized
+        if (cameraTable.size() == 0) {
+            cameraTable.reserve(estimateRows(begin, end));
+        }
+        parseRange(begin, end, cameraTable, errors);
+        timer.setRows(cameraTable.size() - rowsBefore);
+        return;
+    }
+
+    // Cut the buffer into chunks of about equal size, moving each cut forward to just after a newline
+    vector<const char*> cuts(chunkCount + 1);
+    cuts[0] = begin;
+    cuts[chunkCount] = end;
+    for (size_t c = 1; c < chunkCount; c++) {
+        const char* guess = max(cuts[c - 1], begin + bytes / chunkCount * c);
+        const char* newline = static_cast<const char*>(memchr(guess, '\n', end - guess));
+        cuts[c] = newline == nullptr ? end : newline + 1;
+    }
+
+    // Parse every chunk into its own table, then join them in order
+    vector<CameraTable> parts(chunkCount);
+    vector<RowErrors> partErrors(chunkCount);
+    parallelFor(chunkCount, threads, [&](size_t c) {
+        parts[c].setRegion(region);
+        parts[c].reserve(estimateRows(cuts[c], cuts[c + 1]));
+        parseRange(cuts[c], cuts[c + 1], parts[c], partErrors[c]);
+    });
+    for (const RowErrors& part : partErrors) {
+        errors.merge(part);
+    }
+    ScopedTimer joinTimer("join chunks");
+    cameraTable.append(parts, threads);
+    joinTimer.setRows(cameraTable.size() - rowsBefore);
+    timer.setRows(cameraTable.size() - rowsBefore);
+}
+
+/**
+ * Picks the program that decompresses a file from its first bytes
+ * @param begin First byte of the file
+ * @param end One past the last byte of the file
+ * @return "gzip -dc" or "zstd -dc", or nullptr if the file is not compressed
+ */
+const char* decompressCommand(const char* begin, const char* end) {
+    static const unsigned char gzipMagic[] = {0x1f, 0x8b};
+    static const unsigned char zstdMagic[] = {0x28, 0xb5, 0x2f, 0xfd};
+    size_t size = end - begin;
+    if (size >= sizeof(gzipMagic) && memcmp(begin, gzipMagic, sizeof(gzipMagic)) == 0) {
+        return "gzip -dc";
+    }
+    if (size >= sizeof(zstdMagic) && memcmp(begin, zstdMagic, sizeof(zstdMagic)) == 0) {
+        return "zstd -dc";
+    }
+    return nullptr;
+}
+
+/**
+ * Parses a compressed file as it is decompressed, without writing the
+ * decompressed data anywhere. The decompressor runs as its own process; a
+ * reader thread cuts its output into blocks that end on a newline and queues
+ * them, while this thread parses the previous block. The load therefore takes
+ * about as long as the slower of decompressing and parsing
+ * @param fileName File to read
+ * @param command Decompressor from decompressCommand()
+ * @param region Region given to every new row
+ * @param cameraTable Table receiving the rows
+ * @param errors Receives the lines that were set aside
+ * @param rejectedLines Receives copies of those lines, which errors then points to, as the blocks are freed
+ * @return false if the decompressor failed, in which case the rows are incomplete
+ */
+bool parseCompressed(const string& fileName, const char* command, const string& region,
+                     CameraTable& cameraTable, RowErrors& errors, deque<string>& rejectedLines) {
+    // Quote the name for the shell, writing each ' as '\''
+    string quotedName = "'";
+    for (char c : fileName) {
+        quotedName += c == '\'' ? string("'\\''") : string(1, c);
+    }
+    FILE* pipe = popen((string(command) + " " + quotedName + "'").c_str(), "r");
+    if (pipe == nullptr) {
+        return false;
+    }
+
+    // Four blocks of 4 MB are enough to keep both sides busy
+    const size_t blockBytes = 4 << 20;
+    BlockQueue queue(4);
+    thread reader([&]() {
+        ScopedTimer timer("decompress");
+        string carry; // Start of a line the last block cut off
+        uint64_t total = 0;
+        while (true) {
+            string block = move(carry);
+            size_t start = block.size();
+            block.resize(start + blockBytes);
+            size_t got = fread(&block[start], 1, blockBytes, pipe);
+            block.resize(start + got);
+            total += got;
+            if (got == 0) {
+                if (!block.empty()) {
+                    queue.push(move(block));
+                }
+                break;
+            }
+            size_t lastNewline = block.find_last_of('\n');
+            carry = lastNewline == string::npos ? move(block) : block.substr(lastNewline + 1);
+            if (lastNewline != string::npos) {
+                block.resize(lastNewline + 1);
+                queue.push(move(block));
+            }
+        }
+        timer.setBytes(total);
+        queue.close();
+    });
+
+    ScopedTimer timer("parse");
+    cameraTable.setRegion(region);
+    string block;
+    while (queue.pop(block)) {
+        size_t rejected = errors.total();
+        parseRange(block.data(), block.data() + block.size(), cameraTable, errors);
+        for (size_t e = rejected; e < errors.total(); e++) {
+            rejectedLines.emplace_back(errors.lines[e]);
+            errors.lines[e] = rejectedLines.back();
+        }
+    }
+    reader.join();
+    timer.setRows(cameraTable.size());
+    return pclose(pipe) == 0;
+}
+
+/**
+ * Reads camera violation data from a CSV file by mapping it into memory and
+ * splitting each line in place; large files are parsed on several threads (see parseBuffer())
+ * When snapshots are on, the parsed table is also saved next to the file as
+ * <fileName>.snap and later runs load that instead of parsing again, as long as
+ * the file's size and modification time have not changed
+ * Every row's region is set to the file's name without directory or extension
+ * Malformed lines are not loaded: they are written to <fileName>.rejects and counted on cerr
+ * gzip and zstd files are recognized by their first bytes and decompressed while they are parsed
+ * @param fileName The name of the CSV file to read
+ * @param threads Number of threads to parse with, 0 uses every hardware thread
+ * @param useSnapshot Whether to load and save a binary snapshot
+ * @param rollup If given, receives the table's rollup cube, loaded from the snapshot when possible
+ * @param loaded If given, set to whether the file could be opened and decompressed
+ * @pre fileName exists
+ * @post the returned table owns all of its text, so the file is unmapped again
+ * @return table storing all camera records, in file order; empty if the file could not be read
+ */
+CameraTable readFile(string fileName, int threads, bool useSnapshot, RollupCube* rollup, bool* loaded) {
+    ScopedTimer timer("load file");
+    CameraTable cameraTable;
+    MappedFile mappedFile;
+
+    if (loaded != nullptr) {
+        *loaded = false;
+    }
+    if (!mappedFile.open(fileName)) {
+        cout << "Unable to open file." << endl;
+        return cameraTable;
+    }
+    if (threads <= 0) {
+        threads = defaultThreads();
+    }
+    timer.setBytes(mappedFile.getSize());
+
+    // A snapshot is only used if it was built from this exact version of the file
+    string snapshotName = fileName + ".snap";
+    struct stat info;
+    stat(fileName.c_str(), &info);
+    if (useSnapshot) {
+        ScopedTimer loadTimer("snapshot load");
+        SnapshotReader reader;
+        if (reader.open(snapshotName, info) && cameraTable.load(reader)) {
+            // The cube follows the table in the snapshot
+            if (rollup != nullptr && !rollup->load(reader, cameraTable)) {
+                rollup->build(cameraTable, threads);
+            }
+            loadTimer.setRows(cameraTable.size());
+            timer.setRows(cameraTable.size());
+            if (loaded != nullptr) {
+                *loaded = true;
+            }
+            return cameraTable;
+        }
+        cameraTable = CameraTable();
+    }
+
+    // Every row remembers which file it came from
+    RowErrors errors;
+    deque<string> rejectedLines; // Decompressed text of the rejected lines
+    const char* decompressor = decompressCommand(mappedFile.begin(), mappedFile.end());
+    if (decompressor == nullptr) {
+        parseBuffer(mappedFile.begin(), mappedFile.end(), regionName(fileName), threads, cameraTable, errors);
+    }
+    else if (!parseCompressed(fileName, decompressor, regionName(fileName), cameraTable, errors, rejectedLines)) {
+        cerr << "Unable to decompress file: " << fileName << endl;
+        return CameraTable();
+    }
+    timer.setRows(cameraTable.size());
+    if (loaded != nullptr) {
+        *loaded = true;
+    }
+
+    // Quarantine the malformed lines so they can be fixed and loaded again
+    string rejectsName = fileName + ".rejects";
+    if (errors.total() > 0) {
+        ofstream rejects(rejectsName, ios::binary);
+        for (string_view line : errors.lines) {
+            rejects << line << '\n';
+        }
+        cerr << fileName << ": skipped " << errors.summary() << ", see " << rejectsName << endl;
+    }
+    else {
+        remove(rejectsName.c_str());
+    }
+
+    // The snapshot always carries the cube, so build one even if the caller does not need it
+    RollupCube builtRollup;
+    if (rollup != nullptr || useSnapshot) {
+        (rollup != nullptr ? *rollup : builtRollup).build(cameraTable, threads);
+    }
+
+    // Save the snapshot under a temporary name first so a half-written file is never loaded
+    if (useSnapshot) {
+        ScopedTimer saveTimer("snapshot save", cameraTable.size());
+        string tempName = snapshotName + ".tmp";
+        SnapshotWriter writer;
+        if (writer.open(tempName, info)) {
+            cameraTable.save(writer);
+            (rollup != nullptr ? *rollup : builtRollup).save(writer);
+            if (writer.finish()) {
+                rename(tempName.c_str(), snapshotName.c_str());
+            }
+        }
+        remove(tempName.c_str());
+    }
+    return cameraTable;
+}
+
+/**
+ * Names the region a data file covers
+ * @param fileName Path of the file, such as "data/north-side.txt" or "data/north-side.txt.gz"
+ * @return the file name without directory, extension or compression suffix, such as "north-side"
+ */
+string regionName(const string& fileName) {
+    size_t slash = fileName.find_last_of('/');
+    string name = slash == string::npos ? fileName : fileName.substr(slash + 1);
+    // A compressed file is named after the file inside it
+    for (const char* suffix : {".gz", ".zst"}) {
+        size_t length = strlen(suffix);
+        if (name.size() > length && name.compare(name.size() - length, length, suffix) == 0) {
+            name.resize(name.size() - length);
+        }
+    }
+    size_t dot = name.find_last_of('.');
+    return dot == string::npos || dot == 0 ? name : name.substr(0, dot);
+}
+
+/**
+ * Turns file names, directories and glob patterns into a list of data files
+ * A directory stands for every .txt and .csv file in it, compressed or not, except
+ * headers.txt, which only describes the columns; a pattern with *, ? or [ is expanded; anything else is kept as given
+ * @param inputs Names as typed by the user
+ * @return file names, sorted within each directory or pattern
+ */
+vector<string> expandInputs(const vector<string>& inputs) {
+    vector<string> fileNames;
+    for (const string& input : inputs) {
+        struct stat info;
+        if (stat(input.c_str(), &info) == 0 && S_ISDIR(info.st_mode)) {
+            vector<string> found;
+            for (const char* pattern : {"/*.txt", "/*.csv", "/*.txt.gz", "/*.csv.gz", "/*.txt.zst", "/*.csv.zst"}) {
+                glob_t matches;
+                if (glob((input + pattern).c_str(), 0, nullptr, &matches) == 0) {
+                    copy_if(matches.gl_pathv, matches.gl_pathv + matches.gl_pathc, back_inserter(found),
+                            [](const char* path) { return regionName(path) != "headers"; });
+                }
+                globfree(&matches);
+            }
+            sort(found.begin(), found.end());
+            fileNames.insert(fileNames.end(), found.begin(), found.end());
+        }
+        else if (input.find_first_of("*?[") != string::npos) {
+            glob_t matches;
+            if (glob(input.c_str(), 0, nullptr, &matches) == 0) {
+                fileNames.insert(fileNames.end(), matches.gl_pathv, matches.gl_pathv + matches.gl_pathc);
+            }
+            globfree(&matches);
+        }
+        else {
+            fileNames.push_back(input);
+        }
+    }
+    return fileNames;
+}
+
+/**
+ * Reads several files at the same time and joins them into one table in the order given
+ * The threads are shared out between the files
+ * @param fileNames Files to read
+ * @param threads Number of threads, 0 uses every hardware thread
+ * @param useSnapshot Whether to load and save binary snapshots
+ * @param rollup If given, receives the rollup cube of the joined table; only a single file's cube comes from its
+ *        snapshot, since joining renumbers the ids, so several files always rebuild it
+ * @param loaded If given, set to whether every file could be opened and decompressed
+ * @return table storing the records of every file; each row's region names its file
+ */
+CameraTable readFiles(const vector<string>& fileNames, int threads, bool useSnapshot, RollupCube* rollup,
+                      bool* loaded) {
+    if (threads <= 0) {
+        threads = defaultThreads();
+    }
+    if (fileNames.size() == 1) {
+        return readFile(fileNames[0], threads, useSnapshot, rollup, loaded);
+    }
+    vector<CameraTable> parts(fileNames.size());
+    vector<char> partLoaded(fileNames.size()); // char rather than bool so threads write separate bytes
+    int threadsPerFile = max(1, threads / max(1, (int)fileNames.size()));
+    parallelFor(fileNames.size(), threads, [&](size_t f) {
+        bool fileLoaded;
+        parts[f] = readFile(fileNames[f], threadsPerFile, useSnapshot, nullptr, &fileLoaded);
+        partLoaded[f] = fileLoaded;
+    });
+    if (loaded != nullptr) {
+        *loaded = find(partLoaded.begin(), partLoaded.end(), 0) == partLoaded.end();
+    }
+
+    CameraTable cameraTable;
+    {
+        ScopedTimer timer("join files");
+        cameraTable.append(parts, threads);
+        timer.setRows(cameraTable.size());
+    }
+    // Ids change when tables are joined, so the cubes of the files cannot be reused
+    if (rollup != nullptr) {
+        rollup->build(cameraTable, threads);
+    }
+    return cameraTable;
+}
+
+/**
+ * Measures ingest speed by writing a file that repeats the input several times
+ * and timing readFile on it
+ * @param fileName The CSV file to scale up
+ * @param copies How many times the file is repeated
+ * @post Prints the scaled size, record count and throughput in MB/s
+ */
+void benchmarkIngest(string fileName, int copies) {
+    ifstream fileIn(fileName, ios::binary);
+    if (!fileIn.is_open()) {
+        cout << "Unable to open file." << endl;
+        return;
+    }
+    string contents((istreambuf_iterator<char>(fileIn)), istreambuf_iterator<char>());
+    fileIn.close();
+    countAllocations = true;
+
+    // Build the scaled-up copy next to the system temp files
+    string scaledName = "/tmp/camera-bench-" + to_string(getpid()) + ".txt";
+    ofstream fileOut(scaledName, ios::binary);
+    for (int i = 0; i < copies; i++) {
+        fileOut << contents;
+    }
+    fileOut.close();
+
+    // Load with 1, 2, 4, ... threads up to every hardware thread
+    double megabytes = contents.size() * (double)copies / (1024.0 * 1024.0);
+    double singleThreadSeconds = 0;
+    int maxThreads = defaultThreads();
+    for (int threads = 1; ; threads = min(threads * 2, maxThreads)) {
+        resetPeakMemory();
+        size_t rssBefore = processMemoryKb("VmRSS");
+        uint64_t allocationsBefore = allocationCount, bytesBefore = allocationBytes;
+        auto start = chrono::steady_clock::now();
+        CameraTable cameraTable = readFile(scaledName, threads, false);
+        auto stop = chrono::steady_clock::now();
+        uint64_t allocations = allocationCount - allocationsBefore;
+        double allocatedMb = (allocationBytes - bytesBefore) / (1024.0 * 1024.0);
+        double peakMb = (processMemoryKb("VmHWM") - (double)rssBefore) / 1024.0;
+
+        double seconds = chrono::duration<double>(stop - start).count();
+        if (threads == 1) {
+            singleThreadSeconds = seconds;
+        }
+        cout << fixed << setprecision(1)
+             << threads << " thread(s): read " << megabytes << " MB (" << cameraTable.size() << " records) in "
+             << seconds * 1000 << " ms: " << megabytes / seconds << " MB/s, speedup "
+             << setprecision(2) << singleThreadSeconds / seconds << "x" << endl;
+        cout << setprecision(1) << "  " << allocations << " allocations (" << allocatedMb << " MB), peak memory +"
+             << peakMb << " MB" << endl;
+        if (threads == maxThreads) {
+            cout << setprecision(1) << "Table holds " << cameraTable.memoryUsage() / (1024.0 * 1024.0) << " MB in memory." << endl;
+            break;
+        }
+    }
+
+    // The first snapshot load parses and writes the snapshot, the second one maps it
+    for (string step : {"parse + write snapshot", "load snapshot"}) {
+        auto start = chrono::steady_clock::now();
+        CameraTable cameraTable = readFile(scaledName, maxThreads, true);
+        auto stop = chrono::steady_clock::now();
+        cout << step << ": " << chrono::duration<double, milli>(stop - start).count()
+             << " ms (" << cameraTable.size() << " records)" << endl;
+    }
+    remove((scaledName + ".snap").c_str());
+
+    remove(scaledName.c_str());
+}
+
+/**
+ * Builds a table of made-up records for benchmarks
+ * Every camera belongs to one of 40 neighborhoods and records have random dates in 2023
+ * @param rows Number of records to generate
+ * @param cameras Number of distinct cameras
+ * @return the generated table
+ */
+CameraTable makeSyntheticTable(size_t rows, int cameras) {
+    vector<string> cameraNames, intersections, addresses, neighborhoods;
+    for (int i = 0; i < cameras; i++) {
+        cameraNames.push_back(to_string(1000 + i));
+        intersections.push_back("STREET " + to_string(i) + " AND AVENUE " + to_string(i % 97));
+        addresses.push_back(to_string(100 * i) + " W STREET " + to_string(i));
+        neighborhoods.push_back("Neighborhood " + to_string(i % 40));
+    }
+
+    CameraTable cameraTable;
+    cameraTable.setRegion("synthetic");
+    cameraTable.reserve(rows);
+    mt19937 random(42); // Fixed seed so every run sees the same data
+    for (size_t i = 0; i < rows; i++) {
+        int camera = random() % cameras;
+        uint32_t date = packDate(2023, 1 + random() % 12, 1 + random() % 28);
+        cameraTable.addRecord(intersections[camera], addresses[camera], cameraNames[camera],
+                              date, random() % 60, neighborhoods[camera]);
+    }
+    return cameraTable;
+}
+
+/**
+ * Times the neighborhood aggregation with the original find()-based loops
+ * against the hash-based GroupAggregator and the rollup cube on synthetic tables
+ * The original loops are only run up to 10 million rows because they are quadratic
+ * @param rowCounts Table sizes to measure
+ * @post Prints the time of both versions for each size
+ */
+void benchmarkAggregation(const vector<size_t>& rowCounts) {
+    for (size_t rows : rowCounts) {
+        CameraTable cameraTable = makeSyntheticTable(rows, 300);
+        const vector<int32_t>& neighborhoodIds = cameraTable.getNeighColumn();
+        const vector<int32_t>& cameraIds = cameraTable.getCamColumn();
+        const vector<int32_t>& violations = cameraTable.getVioColumn();
+        cout << fixed << setprecision(1) << rows << " rows:" << endl;
+
+        // Hash-based: one pass over the rows
+        auto start = chrono::steady_clock::now();
+        GroupAggregator groups;
+        for (size_t i = 0; i < rows; i++) {
+            groups.add(neighborhoodIds[i], violations[i], cameraIds[i]);
+        }
+        auto stop = chrono::steady_clock::now();
+        cout << "  hash aggregation: " << chrono::duration<double, milli>(stop - start).count()
+             << " ms for " << groups.size() << " neighborhoods" << endl;
+
+        // Fused overview: every dataOverview statistic in one pass
+        start = chrono::steady_clock::now();
+        OverviewStats stats;
+        stats.scan(cameraTable, 0, rows);
+        stop = chrono::steady_clock::now();
+        cout << "  fused overview:   " << chrono::duration<double, milli>(stop - start).count()
+             << " ms for " << stats.getCameraCount() << " cameras" << endl;
+
+        // Rollup: built once, after which each report reads a few hundred cells
+        start = chrono::steady_clock::now();
+        RollupCube rollup;
+        rollup.build(cameraTable, defaultThreads());
+        stop = chrono::steady_clock::now();
+        cout << "  rollup build:     " << chrono::duration<double, milli>(stop - start).count() << " ms" << endl;
+        start = chrono::steady_clock::now();
+        GroupAggregator rollupGroups = rollup.neighborhoodGroups();
+        MonthTotals rollupMonths = rollup.monthTotals();
+        stop = chrono::steady_clock::now();
+        cout << "  rollup reports:   " << chrono::duration<double, micro>(stop - start).count()
+             << " us for " << rollupGroups.size() << " neighborhoods and "
+             << rollupMonths.getViolations(1) << " January violations" << endl;
+
+        if (rows > 10000000) {
+            cout << "  find() loops:     skipped" << endl;
+            continue;
+        }
+
+        // Original: one rescan of the rows per neighborhood with find() on seen cameras
+        start = chrono::steady_clock::now();
+        vector<int32_t> uniqueNeighborhoods;
+        for (size_t i = 0; i < rows; i++) {
+            if (find(uniqueNeighborhoods.begin(), uniqueNeighborhoods.end(), neighborhoodIds[i]) == uniqueNeighborhoods.end()) {
+                uniqueNeighborhoods.push_back(neighborhoodIds[i]);
+            }
+        }
+        int64_t checksum = 0;
+        for (int32_t neigh : uniqueNeighborhoods) {
+            vector<int32_t> uniqueCameras;
+            for (size_t j = 0; j < rows; j++) {
+                if (neighborhoodIds[j] == neigh) {
+                    checksum += violations[j];
+                    if (find(uniqueCameras.begin(), uniqueCameras.end(), cameraIds[j]) == uniqueCameras.end()) {
+                        uniqueCameras.push_back(cameraIds[j]);
+                    }
+                }
+            }
+            checksum += uniqueCameras.size();
+        }
+        stop = chrono::steady_clock::now();
+        cout << "  find() loops:     " << chrono::duration<double, milli>(stop - start).count()
+             << " ms (checksum " << checksum << ")" << endl;
+    }
+}
+
+/**
+ * Runs reports without prompting: loads every file into one table, then runs
+ * each report in the order given, writing only report output to cout
+ * @param fileNames Files, directories or glob patterns to load, appended in order
+ * @param reports (report name, argument) pairs; the argument is the term of "search" and the kind of "top"
+ * @param format Output format for every report
+ * @param threads Number of threads, 0 uses every hardware thread
+ * @param useSnapshot Whether files are loaded from and saved to snapshots
+ * @param useIndex Whether searches use the trigram index
+ * @param approximate Whether overview and neighborhood camera counts and the busiest intersections come from sketches
+ * @param query Date range and list length of the top and yearmonth reports
+ * @param filter If given, the overview, neighborhood, month and region reports only cover the rows it selects
+ * @return exit code for main(), 1 if a file could not be loaded or the filter names an unknown value
+ */
+int runBatch(const vector<string>& fileNames, const vector<pair<string, string>>& reports,
+             OutputFormat format, int threads, bool useSnapshot, bool useIndex, bool approximate,
+             const DateQuery& query, const RowFilter* filter) {
+    if (threads <= 0) {
+        threads = defaultThreads();
+    }
+
+    // Load every file at once and join them in command-line order
+    vector<string> expanded = expandInputs(fileNames);
+    if (expanded.empty()) {
+        cerr << "No files matched." << endl;
+        return 1;
+    }
+    for (const string& fileName : expanded) {
+        if (access(fileName.c_str(), R_OK) != 0) {
+            cerr << "Unable to open file: " << fileName << endl;
+            return 1;
+        }
+    }
+    RollupCube rollup;
+    bool loaded;
+    CameraTable cameraTable = readFiles(expanded, threads, useSnapshot, &rollup, &loaded);
+    if (!loaded) {
+        return 1;
+    }
+
+    // Only build the search index when a search was asked for
+    SearchIndex searchIndex;
+    bool hasSearch = false;
+    for (const pair<string, string>& report : reports) {
+        hasSearch = hasSearch || report.first == "search";
+    }
+    if (hasSearch && useIndex) {
+        searchIndex.build(cameraTable);
+    }
+    // Top cameras come from the rollup; intersections, days and months need the date index
+    DateIndex dateIndex;
+    for (const pair<string, string>& report : reports) {
+        if (!dateIndex.isBuilt() && (report.first == "yearmonth" || (report.first == "top" && report.second != "cameras"))) {
+            dateIndex.build(cameraTable);
+        }
+    }
+    CameraSketches sketches;
+    if (approximate) {
+        sketches.build(cameraTable, threads);
+    }
+    // A filter is answered from bitmaps of its columns, and only the selected rows are aggregated
+    FilteredAggregates filtered;
+    if (filter != nullptr) {
+        BitmapIndex bitmapIndex;
+        bitmapIndex.build(cameraTable, threads);
+        RowBitmap rows;
+        string error;
+        if (!filterRows(cameraTable, bitmapIndex, *filter, rows, error)) {
+            cerr << "Invalid filter: " << error << endl;
+            return 1;
+        }
+        filtered = aggregateRows(cameraTable, rows, threads);
+
+        OutputBuffer& out = OutputBuffer::standard();
+        if (format == TEXT_FORMAT) {
+            out << "Rows matching " << filter->text << ": " << rows.count() << "\n";
+        }
+        else {
+            TableEmitter table(out, format, "filter", {"filter", "records"});
+            table.field(filter->text);
+            table.field(rows.count());
+            table.endRow();
+            table.finish();
+        }
+        out.flush();
+    }
+    dumpProfile();
+
+    for (const pair<string, string>& report : reports) {
+        if (filter != nullptr && report.first == "overview") {
+            ScopedTimer timer("report overview (filtered)", filtered.overview.getRecords());
+            printOverview(cameraTable, filtered.overview, format);
+        }
+        else if (filter != nullptr && report.first == "neighborhood") {
+            ScopedTimer timer("report neighborhood (filtered)", filtered.overview.getRecords());
+            printNeighborhoods(cameraTable, filtered.neighborhoods, format);
+        }
+        else if (filter != nullptr && report.first == "month") {
+            ScopedTimer timer("report month (filtered)", filtered.overview.getRecords());
+            printMonthChart(filtered.months, format);
+        }
+        else if (filter != nullptr && report.first == "region") {
+            ScopedTimer timer("report region (filtered)", filtered.overview.getRecords());
+            printRegions(cameraTable, filtered.regions, format);
+        }
+        else if (report.first == "overview") {
+            dataOverview(cameraTable, rollup, format, approximate ? &sketches : nullptr);
+        }
+        else if (report.first == "neighborhood") {
+            resultsByNeighborhood(cameraTable, rollup, format, approximate ? &sketches : nullptr);
+        }
+        else if (report.first == "month") {
+            displayChartByMonth(cameraTable, rollup, format);
+        }
+        else if (report.first == "region") {
+            resultsByRegion(cameraTable, threads, format);
+        }
+        else if (report.first == "yearmonth") {
+            displayYearMonths(dateIndex, query, format);
+        }
+        else if (report.first == "top") {
+            displayTop(cameraTable, rollup, dateIndex, report.second, query, format);
+        }
+        else {
+            displaySearchResults(cameraTable, searchIndex, report.second, format);
+        }
+        dumpProfile();
+    }
+    cout.flush();
+    return 0;
+}
+
+/**
+ * Parses a whole number given on the command line
+ * @param text Number as typed by the user
+ * @param minimum Smallest number allowed
+ * @param maximum Largest number allowed
+ * @param value Receives the number
+ * @return true if text is only digits (with an optional minus sign) and the number is in range
+ */
+bool parseCount(string_view text, long long minimum, long long maximum, long long& value) {
+    const char* end = text.data() + text.size();
+    from_chars_result result = from_chars(text.data(), end, value);
+    return result.ec == errc() && result.ptr == end && !text.empty() && value >= minimum && value <= maximum;
+}
+
+/**
+ * Parses a filter such as "neighborhood=Lincoln Park and month=7 or camera=1413"
+ * Terms are <column>=<value> with column neighborhood, month or camera, joined
+ * by "and" and "or" (any case); "and" binds tighter. Values are checked against
+ * the data by filterRows()
+ * @param text Filter as typed by the user
+ * @param filter Receives the parsed filter
+ * @param error Receives what is wrong when the filter cannot be parsed
+ * @return true if the filter was parsed
+ */
+bool parseFilter(const string& text, RowFilter& filter, string& error) {
+    filter = RowFilter();
+    filter.text = text;
+    string lower = text;
+    transform(lower.begin(), lower.end(), lower.begin(), ::tolower);
+
+    filter.anyOf.emplace_back();
+    size_t start = 0;
+    while (true) {
+        // The term runs up to the next " and " or " or "
+        size_t andPos = lower.find(" and ", start), orPos = lower.find(" or ", start);
+        size_t end = min(andPos, orPos);
+        string term = text.substr(start, end == string::npos ? string::npos : end - start);
+
+        size_t equals = term.find('=');
+        if (equals == string::npos) {
+            error = "expected <column>=<value> in \"" + term + "\"";
+            return false;
+        }
+        // Spaces around the column and value do not matter
+        auto trim = [](string value) {
+            value.erase(0, value.find_first_not_of(' '));
+            value.erase(value.find_last_not_of(' ') + 1);
+            return value;
+        };
+        string column = trim(term.substr(0, equals)), value = trim(term.substr(equals + 1));
+        transform(column.begin(), column.end(), column.begin(), ::tolower);
+        if (column != "neighborhood" && column != "month" && column != "camera") {
+            error = "unknown column \"" + column + "\" (expected neighborhood, month or camera)";
+            return false;
+        }
+        if (value.empty()) {
+            error = "no value for " + column;
+            return false;
+        }
+        filter.anyOf.back().push_back(make_pair(column, value));
+
+        if (end == string::npos) {
+            return true;
+        }
+        if (end == orPos) {
+            filter.anyOf.emplace_back();
+            start = end + 4;
+        }
+        else {
+            start = end + 5;
+        }
+    }
+}
+
+/**
+ * Finds the rows a filter selects by combining bitmaps, without reading the table's rows
+ * Neighborhoods and months (1-12 or a name) match ignoring case; cameras match exactly
+ * @param bitmapIndex Bitmaps built from cameraTable
+ * @param rows Receives the selected rows
+ * @param error Receives the value that is not in the data, if any
+ * @return false if a value is not in the data
+ */
+bool filterRows(const CameraTable& cameraTable, const BitmapIndex& bitmapIndex, const RowFilter& filter,
+                RowBitmap& rows, string& error) {
+    ScopedTimer timer("filter");
+    auto equalsIgnoringCase = [](string_view text, string lowerValue) {
+        transform(lowerValue.begin(), lowerValue.end(), lowerValue.begin(), ::tolower);
+        return text.size() == lowerValue.size() && containsIgnoreCase(text, lowerValue);
+    };
+
+    rows = RowBitmap();
+    for (const vector<pair<string, string>>& allOf : filter.anyOf) {
+        // The bitmap of every term of the group, smallest first so the AND shrinks quickly
+        vector<const RowBitmap*> terms;
+        for (const pair<string, string>& term : allOf) {
+            const RowBitmap* bitmap = nullptr;
+            if (term.first == "neighborhood") {
+                for (int32_t id = 0; id < cameraTable.getNeighCount() && bitmap == nullptr; id++) {
+                    if (equalsIgnoringCase(cameraTable.getNeigh(id), term.second)) {
+                        bitmap = &bitmapIndex.getNeighborhoodRows(id);
+                    }
+                }
+            }
+            else if (term.first == "camera") {
+                for (int32_t id = 0; id < cameraTable.getCamCount() && bitmap == nullptr; id++) {
+                    if (cameraTable.getCamNum(id) == term.second) {
+                        bitmap = &bitmapIndex.getCameraRows(id);
+                    }
+                }
+            }
+            else {
+                for (int month = 1; month <= 12 && bitmap == nullptr; month++) {
+                    if (term.second == to_string(month) || equalsIgnoringCase(getMonth(month), term.second)) {
+                        bitmap = &bitmapIndex.getMonthRows(month);
+                    }
+                }
+            }
+            if (bitmap == nullptr) {
+                error = "no " + term.first + " \"" + term.second + "\" in the data";
+                return false;
+            }
+            terms.push_back(bitmap);
+        }
+        sort(terms.begin(), terms.end(), [](const RowBitmap* a, const RowBitmap* b) { return a->count() < b->count(); });
+        RowBitmap group = *terms[0];
+        for (size_t t = 1; t < terms.size(); t++) {
+            group = group.intersect(*terms[t]);
+        }
+        rows = rows.unite(group);
+    }
+    timer.setRows(rows.count());
+    return true;
+}
+
+/**
+ * Aggregates only the rows of a bitmap for the overview, neighborhood, month and region reports
+ * Each chunk of the bitmap is aggregated on its own task, a run of consecutive
+ * rows at a time, and the partial results are merged in row order
+ * @param rows Rows to aggregate
+ * @param threads Number of threads
+ */
+FilteredAggregates aggregateRows(const CameraTable& cameraTable, const RowBitmap& rows, int threads) {
+    ScopedTimer timer("filtered aggregate", rows.count());
+    const vector<int32_t>& neighborhoodIds = cameraTable.getNeighColumn();
+    const vector<int32_t>& regionIds = cameraTable.getRegionColumn();
+    const vector<int32_t>& cameraIds = cameraTable.getCamColumn();
+    const vector<int32_t>& violations = cameraTable.getVioColumn();
+
+    vector<FilteredAggregates> partials(rows.chunkCount());
+    parallelFor(rows.chunkCount(), threads, [&](size_t c) {
+        FilteredAggregates& partial = partials[c];
+        rows.forEachRun(c, [&](size_t begin, size_t end) {
+            partial.overview.scan(cameraTable, begin, end);
+            partial.months.scan(cameraTable, begin, end);
+            for (size_t i = begin; i < end; i++) {
+                partial.neighborhoods.add(neighborhoodIds[i], violations[i], cameraIds[i]);
+                partial.regions.add(regionIds[i], violations[i], cameraIds[i]);
+            }
+        });
+    });
+    FilteredAggregates result;
+    for (const FilteredAggregates& partial : partials) {
+        result.overview.merge(partial.overview);
+        result.neighborhoods.merge(partial.neighborhoods);
+        result.regions.merge(partial.regions);
+        result.months.merge(partial.months);
+    }
+    return result;
+}
+
+/**
+ * Follows a file that grows over time, like "tail -f": after the first load it
+ * checks the file every interval, parses only the bytes appended since the last
+ * check and updates the overview, neighborhood and month aggregates with just
+ * those rows before printing the requested reports again
+ * A partial last line is left for the next check; if the file shrinks, or another file is
+ * moved to its name (as log rotation and editors that save a copy do), it is read again from the start
+ * @param fileName File to follow
+ * @param reports Reports printed after every update; only overview, neighborhood and month apply
+ * @param format Output format
+ * @param threads Number of threads, 0 uses every hardware thread
+ * @param intervalMs Milliseconds between checks
+ * @return exit code for main(), 1 if the file cannot be opened; otherwise runs until stopped
+ */
+int followFile(const string& fileName, const vector<pair<string, string>>& reports,
+               OutputFormat format, int threads, int intervalMs) {
+    if (threads <= 0) {
+        threads = defaultThreads();
+    }
+    int fd = open(fileName.c_str(), O_RDONLY);
+    if (fd < 0) {
+        cerr << "Unable to open file: " << fileName << endl;
+        return 1;
+    }
+    string region = regionName(fileName);
+    CameraTable cameraTable;
+    IncrementalReports aggregates;
+    off_t consumed = 0;   // Bytes of the file already parsed, always ending at a newline
+    string buffer;        // Newly appended bytes
+
+    while (true) {
+        struct stat info, named;
+        if (fstat(fd, &info) != 0) {
+            break;
+        }
+        // A different file under the name was put there in place of the open one: switch to it
+        bool replaced = false;
+        if (stat(fileName.c_str(), &named) == 0 && (named.st_ino != info.st_ino || named.st_dev != info.st_dev)) {
+            int newFd = open(fileName.c_str(), O_RDONLY);
+            struct stat reopened;
+            if (newFd >= 0 && fstat(newFd, &reopened) == 0) {
+                close(fd);
+                fd = newFd;
+                info = reopened;
+                replaced = true;
+            }
+            else if (newFd >= 0) {
+                close(newFd);
+            }
+        }
+        // The file was truncated or replaced: start over
+        if (replaced || info.st_size < consumed) {
+            cameraTable = CameraTable();
+            aggregates = IncrementalReports();
+            consumed = 0;
+        }
+
+        if (info.st_size > consumed) {
+            // Read only the new bytes
+            buffer.resize(info.st_size - consumed);
+            ssize_t got = pread(fd, &buffer[0], buffer.size(), consumed);
+            buffer.resize(got > 0 ? got : 0);
+
+            // Parse up to the last complete line
+            size_t lastNewline = buffer.find_last_of('\n');
+            if (lastNewline != string::npos) {
+                RowErrors errors;
+                parseBuffer(buffer.data(), buffer.data() + lastNewline + 1, region, threads, cameraTable, errors);
+                if (errors.total() > 0) {
+                    cerr << fileName << ": skipped " << errors.summary() << endl;
+                }
+                consumed += lastNewline + 1;
+                size_t added = aggregates.update(cameraTable);
+
+                OutputBuffer& out = OutputBuffer::standard();
+                if (format == TEXT_FORMAT) {
+                    out << "--- " << added << " new records, " << cameraTable.size() << " in total ---\n";
+                }
+                else if (format == TSV_FORMAT) {
+                    out << "# update\t" << added << '\t' << cameraTable.size() << '\n';
+                }
+                else {
+                    TableEmitter table(out, format, "update", {"new_records", "total_records"});
+                    table.field(added);
+                    table.field(cameraTable.size());
+                    table.endRow();
+                    table.finish();
+                }
+                out.flush();
+                for (const pair<string, string>& report : reports) {
+                    if (report.first == "overview") {
+                        printOverview(cameraTable, aggregates.getOverview(), format);
+                    }
+                    else if (report.first == "neighborhood") {
+                        printNeighborhoods(cameraTable, aggregates.getNeighborhoods(), format);
+                    }
+                    else if (report.first == "month") {
+                        printMonthChart(aggregates.getMonths(), format);
+                    }
+                }
+                cout.flush();
+                dumpProfile();
+            }
+        }
+        this_thread::sleep_for(chrono::milliseconds(intervalMs));
+    }
+    close(fd);
+    return 0;
+}
+
+/**
+ * Loads the files once and answers queries from other processes on a Unix domain socket
+ * Each request is one line: "overview", "neighborhood", "month" or "search <term>"
+ * ("quit" closes the connection). The answer is the report in the chosen format,
+ * followed by a line holding only "." so clients know where it ends.
+ * Every client gets its own detached thread; the table, rollup and search index are not
+ * changed after loading, so all clients read them at the same time without locks.
+ * The threads share ownership of that data, so none of them reads it after it is freed
+ * @param fileNames Files, directories or glob patterns to load
+ * @param socketPath Path of the socket; an existing file there is replaced
+ * @param format Output format of the answers
+ * @param threads Number of threads used to load, 0 uses every hardware thread
+ * @param useSnapshot Whether files are loaded from and saved to snapshots
+ * @return exit code for main(), 1 if loading or listening failed; otherwise runs until stopped
+ */
+int serveQueries(const vector<string>& fileNames, const string& socketPath, OutputFormat format,
+                 int threads, bool useSnapshot) {
+    if (threads <= 0) {
+        threads = defaultThreads();
+    }
+    vector<string> expanded = expandInputs(fileNames);
+    if (expanded.empty()) {
+        cerr << "No files matched." << endl;
+        return 1;
+    }
+    for (const string& fileName : expanded) {
+        if (access(fileName.c_str(), R_OK) != 0) {
+            cerr << "Unable to open file: " << fileName << endl;
+            return 1;
+        }
+    }
+    shared_ptr<ServerData> data = make_shared<ServerData>();
+    bool loaded;
+    data->cameraTable = readFiles(expanded, threads, useSnapshot, &data->rollup, &loaded);
+    if (!loaded) {
+        return 1;
+    }
+    data->searchIndex.build(data->cameraTable);
+    dumpProfile();
+
+    sockaddr_un address = {};
+    address.sun_family = AF_UNIX;
+    if (socketPath.size() >= sizeof(address.sun_path)) {
+        cerr << "Socket path is too long: " << socketPath << endl;
+        return 1;
+    }
+    strcpy(address.sun_path, socketPath.c_str());
+    int listener = socket(AF_UNIX, SOCK_STREAM, 0);
+    unlink(socketPath.c_str());
+    if (listener < 0 || bind(listener, (sockaddr*)&address, sizeof(address)) != 0 || listen(listener, SOMAXCONN) != 0) {
+        cerr << "Unable to listen on " << socketPath << ": " << strerror(errno) << endl;
+        return 1;
+    }
+    cerr << "Serving " << data->cameraTable.size() << " records on " << socketPath << endl;
+
+    while (true) {
+        int client = accept(listener, nullptr, nullptr);
+        if (client < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            break;
+        }
+        shared_ptr<const ServerData> shared = data;
+        thread([client, shared, format]() {
+            OutputBuffer output(client);
+            OutputBuffer::redirect(&output);
+            string pending; // Bytes read but not yet split into lines
+            char block[4096];
+            bool open = true;
+            while (open) {
+                ssize_t got = recv(client, block, sizeof(block), 0);
+                if (got <= 0) {
+                    break;
+                }
+                pending.append(block, got);
+                size_t start = 0;
+                for (size_t newline; open && (newline = pending.find('\n', start)) != string::npos; start = newline + 1) {
+                    string request = pending.substr(start, newline - start);
+                    if (!request.empty() && request.back() == '\r') {
+                        request.pop_back();
+                    }
+                    if (request == "quit") {
+                        open = false;
+                        break;
+                    }
+                    if (!answerQuery(request, shared->cameraTable, shared->rollup, shared->searchIndex, format)) {
+                        output << "error: unknown request: " << request << '\n';
+                    }
+                    output << ".\n";
+                    output.flush();
+                    dumpProfile();
+                }
+                pending.erase(0, start);
+            }
+            OutputBuffer::redirect(nullptr);
+            close(client);
+        }).detach();
+    }
+    close(listener);
+    return 0;
+}
+
+/**
+ * Runs one server request and writes its report to this thread's output buffer
+ * @param request Request line without its line break
+ * @return false if the request is not known
+ */
+bool answerQuery(const string& request, const CameraTable& cameraTable, const RollupCube& rollup,
+                 const SearchIndex& searchIndex, OutputFormat format) {
+    if (request == "overview") {
+        dataOverview(cameraTable, rollup, format);
+    }
+    else if (request == "neighborhood") {
+        resultsByNeighborhood(cameraTable, rollup, format);
+    }
+    else if (request == "month") {
+        displayChartByMonth(cameraTable, rollup, format);
+    }
+    else if (request.compare(0, 7, "search ") == 0) {
+        displaySearchResults(cameraTable, searchIndex, request.substr(7), format);
+    }
+    else {
+        return false;
+    }
+    return true;
 }
 
 /**
- * Reads camera violation data from a CSV file and stores it in the global cameraRecords vector
- * @param fileName The name of the CSV file to read
- * @pre fileName exists and is a valid CSV file with the correct format
- * @post cameraRecords vector is populated with CameraRecord objects from the file
- * @return vector storing all camera records
- */
-vector<CameraRecord> readFile(string fileName) {
-    vector<CameraRecord> cameraRecords;
-    ifstream fileIn; // Create ifstream object
-    fileIn.open(fileName); // Open file
-
-    if(fileIn.is_open()) {
-        string intersection, address, cameraNumber, date, violationsStr, neighborhood;
-        int violations;
-
-        // Read file line by line until end of file
-        while (!fileIn.eof()) {
-            // Read each field separated by commas
-            getline(fileIn, intersection, ',');
-            getline(fileIn, address, ',');
-            getline(fileIn, cameraNumber, ',');
-            getline(fileIn, date, ',');
-            getline(fileIn, violationsStr, ',');
-            getline(fileIn, neighborhood);
-            
-            // Convert violations string to integer
-            violations = stoi(violationsStr);
-            
-            // Create and add new CameraRecord to vector
-            cameraRecords.push_back(CameraRecord(intersection, address, cameraNumber, date, violations, neighborhood));
-        }
-        fileIn.close();
+ * Measures the latency of a running server: several clients connect at once and
+ * each sends the requests in turn, waiting for every answer before the next one
+ * Prints the requests per second and the median, p99 and worst latency
+ * @param socketPath Socket the server listens on
+ * @param requests Request lines, sent round-robin
+ * @param clients Number of clients running at the same time
+ * @param repeats Requests sent by each client
+ */
+void benchmarkServer(const string& socketPath, const vector<string>& requests, int clients, int repeats) {
+    vector<vector<double>> latencies(clients); // Microseconds, per client
+    atomic<bool> failed(false);
+
+    auto start = chrono::steady_clock::now();
+    vector<thread> workers;
+    for (int c = 0; c < clients; c++) {
+        workers.emplace_back([&, c]() {
+            sockaddr_un address = {};
+            address.sun_family = AF_UNIX;
+            strncpy(address.sun_path, socketPath.c_str(), sizeof(address.sun_path) - 1);
+            int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+            if (fd < 0 || connect(fd, (sockaddr*)&address, sizeof(address)) != 0) {
+                failed = true;
+                if (fd >= 0) {
+                    close(fd);
+                }
+                return;
+            }
+            string answer;
+            char block[1 << 16];
+            for (int r = 0; r < repeats && !failed; r++) {
+                string request = requests[(c + r) % requests.size()] + "\n";
+                auto sent = chrono::steady_clock::now();
+                if (send(fd, request.data(), request.size(), MSG_NOSIGNAL) != (ssize_t)request.size()) {
+                    failed = true;
+                    break;
+                }
+                // An answer ends with a line holding only "."
+                answer.clear();
+                while (!(answer.size() >= 2 && answer.compare(answer.size() - 2, 2, ".\n") == 0
+                         && (answer.size() == 2 || answer[answer.size() - 3] == '\n'))) {
+                    ssize_t got = recv(fd, block, sizeof(block), 0);
+                    if (got <= 0) {
+                        failed = true;
+                        break;
+                    }
+                    answer.append(block, got);
+                }
+                latencies[c].push_back(chrono::duration<double, micro>(chrono::steady_clock::now() - sent).count());
+            }
+            close(fd);
+        });
     }
-    else {
-        cout << "Unable to open file." << endl;
+    for (thread& worker : workers) {
+        worker.join();
+    }
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    vector<double> all;
+    for (const vector<double>& clientLatencies : latencies) {
+        all.insert(all.end(), clientLatencies.begin(), clientLatencies.end());
+    }
+    if (failed || all.empty()) {
+        cerr << "Unable to query the server on " << socketPath << endl;
+        return;
     }
-    return cameraRecords;
+    sort(all.begin(), all.end());
+    cout << fixed << setprecision(1) << all.size() << " requests from " << clients << " clients: "
+         << all.size() / seconds << " requests/s" << endl;
+    cout << "  median " << all[all.size() / 2] << " us, p99 " << all[min(all.size() - 1, all.size() * 99 / 100)]
+         << " us, max " << all.back() << " us" << endl;
 }
 
 /**
@@ -159,195 +4449,531 @@ vector<CameraRecord> readFile(string fileName) {
  * - Number of unique cameras
  * - Total number of violations
  * - Day with the most violations
- * @pre cameraRecords vector is not empty
+ * @param rollup Aggregates of cameraTable, see RollupCube
+ * @param format Console text, TSV, CSV or JSON
+ * @param sketches If given, the camera count is estimated from them and the busiest intersections are added
+ * @pre cameraTable is not empty
  * @post Displays formatted overview information to the console
  */
-void dataOverview(const vector<CameraRecord>& cameraRecords) {
+void dataOverview(const CameraTable& cameraTable, const RollupCube& rollup, OutputFormat format,
+                  const CameraSketches* sketches) {
     /*
     CASE 1 
     */    
 
-    // Display number of records
-    int fileSize = cameraRecords.size();
-    cout << "Read file with " << fileSize << " records." << endl;
+    ScopedTimer timer("report overview", cameraTable.size());
+    // Every statistic was gathered in one pass when the rollup was built
+    printOverview(cameraTable, rollup.getOverview(), format, sketches);
+}
 
-    // Count unique cameras using a vector to track seen cameras
-    vector<string> uniqueCameras; // Vector to store unique camera IDs
+/**
+ * Displays overview statistics gathered from a table
+ * @param stats Statistics of cameraTable's rows, or of the rows a filter selected
+ * @param format Console text, TSV, CSV or JSON
+ * @param sketches Approximate statistics of the same rows, or nullptr for exact numbers only
+ */
+void printOverview(const CameraTable& cameraTable, const OverviewStats& stats, OutputFormat format,
+                   const CameraSketches* sketches) {
+    ScopedTimer timer("output");
+    OutputBuffer& out = OutputBuffer::standard();
+    int64_t cameraCount = sketches != nullptr ? sketches->getCameraCount() : stats.getCameraCount();
+    vector<pair<SpaceSaving::Counter, int64_t>> busiest;
+    if (sketches != nullptr) {
+        busiest = sketches->topIntersections(5);
+    }
+    // Day with maximum violations, the first row wins on ties
+    int max = stats.getMaxViolations();
+    size_t maxRow = stats.getMaxRow();
+    uint32_t maxDate = max > 0 ? cameraTable.getDateColumn()[maxRow] : 0;
+    string_view maxInter = max > 0 ? cameraTable.getInter(cameraTable.getInterColumn()[maxRow]) : string_view();
 
-    for (int i = 0; i < cameraRecords.size(); i++) { // Looping through all records 
-        CameraRecord record = cameraRecords.at(i);
-        string camID = record.getCamNum();
-        
-        // Only add camera if it hasn't been seen before
-        if (find(uniqueCameras.begin(), uniqueCameras.end(), camID) == uniqueCameras.end()) {
-            uniqueCameras.push_back(camID);
+    if (format != TEXT_FORMAT) {
+        // Dates are written as zero-padded YYYY-MM-DD so they sort as text
+        TableEmitter table(out, format, "overview",
+                           {"records", "cameras", "violations", "max_violations", "max_date", "max_intersection"});
+        table.field(stats.getRecords());
+        table.field(cameraCount);
+        table.field(stats.getTotalViolations());
+        table.field(max);
+        table.field(max > 0 ? isoDate(maxDate) : string());
+        table.field(maxInter);
+        table.endRow();
+        table.finish();
+        if (sketches != nullptr) {
+            TableEmitter busiestTable(out, format, "busiest-intersections", {"rank", "intersection", "violations", "max_error"});
+            for (size_t rank = 0; rank < busiest.size(); rank++) {
+                busiestTable.field(rank + 1);
+                busiestTable.field(busiest[rank].first.name);
+                busiestTable.field(busiest[rank].first.count);
+                busiestTable.field(busiest[rank].second);
+                busiestTable.endRow();
+            }
+            busiestTable.finish();
         }
+        out.flush();
+        return;
     }
 
-    int count = uniqueCameras.size();
-    cout << "There are " << count << " cameras." << endl;
-
-    // Calculate total violations across all records
-    int sum = 0;
-    for (int i = 0; i < cameraRecords.size(); i++) { // Looping through all records 
-        CameraRecord record = cameraRecords.at(i);
-        int numViolations = record.getVio();
-        sum += numViolations;
+    out << "Read file with " << cameraTable.size() << " records";
+    if ((size_t)stats.getRecords() != cameraTable.size()) {
+        out << ", " << stats.getRecords() << " of them matching the filter";
     }
-    cout << "A total of " << sum << " violations." << endl;
+    out << ".\n";
+    out << "There are " << (sketches != nullptr ? "about " : "") << cameraCount << " cameras.\n";
+    out << "A total of " << stats.getTotalViolations() << " violations.\n";
 
-    // Find day with maximum violations
-    int max = 0;
-    string maxDate, maxInter;
-    for (int i = 0; i < cameraRecords.size(); i++) { // Looping through all records 
-        CameraRecord record = cameraRecords.at(i);
-        int numViolations = record.getVio();
+    // Print the date in MM-DD-YYYY format
+    out << "The most violations in one day were " << max << " on ";
+    if (max > 0) {
+        out << dateMonth(maxDate) << '-' << dateDay(maxDate) << '-' << dateYear(maxDate);
+    }
+    out << " at " << maxInter << '\n';
 
-        if (numViolations > max) {
-            max = numViolations;
-            maxDate = record.getDate();
-            maxInter = record.getInter();
+    // Counts are upper estimates, at most the given error too high
+    if (sketches != nullptr) {
+        out << "Busiest intersections (approximate):\n";
+        for (size_t rank = 0; rank < busiest.size(); rank++) {
+            out.padLeft(rank + 1, 4) << ". ";
+            out.padRight(busiest[rank].first.name, 30).padLeft(busiest[rank].first.count, 8);
+            out << " (up to " << busiest[rank].second << " over)\n";
         }
-    } 
+    }
+    out.flush();
+}
 
-    // Convert date from YYYY-MM-DD to MM-DD-YYYY format
-    string year = maxDate.substr(0, 4);  // Year is always 4 digits
-    
-    // Find the positions of the hyphens
-    int firstHyphen = maxDate.find('-', 4); 
-    int secondHyphen = maxDate.find('-', firstHyphen + 1);
-    
-    // Extract month and day
-    string month = maxDate.substr(firstHyphen + 1, secondHyphen - firstHyphen - 1);
-    string day = maxDate.substr(secondHyphen + 1);
-    
-    // Create the reversed date format
-    string dateReversed = month + "-" + day + "-" + year;
+/**
+ * Groups the rows by an id column, summing violations and counting unique cameras per id
+ * Row ranges are grouped on separate threads and the partial groups are merged in row order
+ * @param keys Id column to group by, such as the neighborhood column
+ * @param threads Number of threads used for the scan
+ * @return one group per id, numbered in order of first appearance
+ */
+GroupAggregator groupByColumn(const CameraTable& cameraTable, const vector<int32_t>& keys, int threads) {
+    const vector<int32_t>& cameraIds = cameraTable.getCamColumn();
+    const vector<int32_t>& violations = cameraTable.getVioColumn();
+
+    size_t rows = cameraTable.size();
+    size_t ranges = scanRanges(rows, threads);
+    vector<GroupAggregator> partials(ranges);
+    parallelFor(ranges, threads, [&](size_t r) {
+        for (size_t i = rows * r / ranges; i < rows * (r + 1) / ranges; i++) {
+            partials[r].add(keys[i], violations[i], cameraIds[i]);
+        }
+    });
+    GroupAggregator groups;
+    for (const GroupAggregator& partial : partials) {
+        groups.merge(partial);
+    }
+    return groups;
+}
 
-    cout << "The most violations in one day were " << max << " on " << dateReversed << " at " << maxInter << endl;
+/**
+ * Orders groups by number of violations in descending order
+ * Groups with equal totals keep the order they first appeared in
+ * @return group numbers in display order
+ */
+vector<int32_t> sortByViolations(const GroupAggregator& groups) {
+    vector<int32_t> sortedGroups(groups.size());
+    for (int32_t i = 0; i < groups.size(); i++) {
+        sortedGroups[i] = i;
+    }
+    stable_sort(sortedGroups.begin(), sortedGroups.end(),
+        [&groups](int32_t a, int32_t b) {
+            return groups.getSum(a) > groups.getSum(b);
+        });
+    return sortedGroups;
 }
 
 /**
  * Displays a sorted list of neighborhoods with their camera counts and total violations
- * @pre cameraRecords vector is not empty
+ * @param rollup Aggregates of cameraTable, see RollupCube
+ * @param format Console text, TSV, CSV or JSON
+ * @param sketches If given, camera counts are estimated from them
+ * @pre cameraTable is not empty
  * @post Displays formatted table of neighborhoods sorted by violation count
  */
-void resultsByNeighborhood(const vector<CameraRecord>& cameraRecords){
+void resultsByNeighborhood(const CameraTable& cameraTable, const RollupCube& rollup, OutputFormat format,
+                           const CameraSketches* sketches){
     /*
     CASE 2
     */
 
-   // Get unique neighborhoods using a vector to track seen neighborhoods
-   vector<string> uniqueNeighborhoods; // Vector to store unique neighborhoods
-
-   for (int i = 0; i < cameraRecords.size(); i++) { // Looping through all records 
-        CameraRecord record = cameraRecords.at(i);
-        string neigh = record.getNeigh();
-        
-        // Only add neighborhood if it hasn't been seen before
-        if (find(uniqueNeighborhoods.begin(), uniqueNeighborhoods.end(), neigh) == uniqueNeighborhoods.end()) {
-            uniqueNeighborhoods.push_back(neigh);
-        }
+    ScopedTimer timer("report neighborhood", cameraTable.size());
+    // Violation sums and unique camera counts per neighborhood come from the rollup
+    GroupAggregator groups;
+    {
+        ScopedTimer aggregateTimer("aggregate");
+        groups = rollup.neighborhoodGroups();
     }
+    printNeighborhoods(cameraTable, groups, format, sketches);
+}
 
-    // Vector to store neighborhood data for sorting
-    vector<tuple<string, int, int>> sortedNeighborhoods; // Store (neighborhood, uniqueCamerasCount, violationsSum)
-    
-    // Process each unique neighborhood
-    for (int i = 0; i < uniqueNeighborhoods.size(); i++) {
-        string currentNeighborhood = uniqueNeighborhoods.at(i);
-        vector<string> uniqueCameras;  // Vector to store unique cameras for this neighborhood
-        int violationsSum = 0; // Store count of violations for each neighborhood
-
-        // Look through all records to find cameras in this neighborhood
-        for (int j = 0; j < cameraRecords.size(); j++) {
-            CameraRecord record = cameraRecords.at(j);
-            if (record.getNeigh() == currentNeighborhood) {
-                int violations = record.getVio(); // Get number of violations
-                violationsSum += violations; // Add to violations sum
+/**
+ * Displays neighborhood groups sorted by violation count
+ * @param groups Rows of cameraTable grouped by neighborhood id
+ * @param format Console text, TSV, CSV or JSON
+ * @param sketches Approximate statistics of the same rows; if given, camera counts come from them
+ */
+void printNeighborhoods(const CameraTable& cameraTable, const GroupAggregator& groups, OutputFormat format,
+                        const CameraSketches* sketches) {
+    vector<int32_t> sortedNeighborhoods;
+    {
+        ScopedTimer timer("sort", groups.size());
+        sortedNeighborhoods = sortByViolations(groups);
+    }
+    ScopedTimer timer("output", groups.size());
+    OutputBuffer& out = OutputBuffer::standard();
+    auto cameras = [&](int32_t group) -> int64_t {
+        return sketches != nullptr ? sketches->getNeighborhoodCameras(cameraTable.getNeigh(groups.getKey(group)))
+                                   : groups.getDistinct(group);
+    };
 
-                string camID = record.getCamNum(); // Get camera id
-                // Only add camera if it's not already in our unique cameras list
-                if (find(uniqueCameras.begin(), uniqueCameras.end(), camID) == uniqueCameras.end()) {
-                    uniqueCameras.push_back(camID);
-                }
-            }
+    if (format != TEXT_FORMAT) {
+        TableEmitter table(out, format, "neighborhood", {"neighborhood", "cameras", "violations"});
+        for (int32_t group : sortedNeighborhoods) {
+            table.field(cameraTable.getNeigh(groups.getKey(group)));
+            table.field(cameras(group));
+            table.field(groups.getSum(group));
+            table.endRow();
         }
+        table.finish();
+        out.flush();
+        return;
+    }
 
-        // Store data for sorting
-        sortedNeighborhoods.push_back(make_tuple(currentNeighborhood, uniqueCameras.size(), violationsSum));
+    // Display results for each neighborhood with proper formatting
+    for (int32_t group : sortedNeighborhoods) {
+        out.padRight(cameraTable.getNeigh(groups.getKey(group)), 25)
+           .padLeft(cameras(group), 4)
+           .padLeft(groups.getSum(group), 7) << '\n';
     }
+    out.flush();
+}
 
-    // Sort the neighborhoods by number of violations in descending order
-    sort(sortedNeighborhoods.begin(), sortedNeighborhoods.end(), 
-        [](const tuple<string, int, int>& a, const tuple<string, int, int>& b) {
-            return get<2>(a) > get<2>(b);  // Compare by violations (third element) in descending order
-        });
+/**
+ * Displays each region (source file) with its record count, camera count and
+ * total violations, sorted by violations, so several loaded files can be compared
+ * @param threads Number of threads used for the scan
+ * @param format Console text, TSV, CSV or JSON
+ * @post Displays formatted table of regions sorted by violation count
+ */
+void resultsByRegion(const CameraTable& cameraTable, int threads, OutputFormat format) {
+    ScopedTimer timer("report region", cameraTable.size());
+    GroupAggregator groups;
+    {
+        ScopedTimer aggregateTimer("aggregate", cameraTable.size());
+        groups = groupByColumn(cameraTable, cameraTable.getRegionColumn(), threads);
+    }
+    printRegions(cameraTable, groups, format);
+}
 
-    // Display results for each neighborhood with proper formatting
-    for (int i = 0; i < sortedNeighborhoods.size(); i++) {
-        // Get the tuple for the current neighborhood
-        string neigh = get<0>(sortedNeighborhoods[i]);  // Get neighborhood name
-        int camCount = get<1>(sortedNeighborhoods[i]);  // Get number of unique cameras
-        int vioSum = get<2>(sortedNeighborhoods[i]);    // Get number of violations
+/**
+ * Displays region groups sorted by violation count
+ * @param groups Rows of cameraTable grouped by region id
+ * @param format Console text, TSV, CSV or JSON
+ */
+void printRegions(const CameraTable& cameraTable, const GroupAggregator& groups, OutputFormat format) {
+    vector<int32_t> sortedRegions;
+    {
+        ScopedTimer sortTimer("sort", groups.size());
+        sortedRegions = sortByViolations(groups);
+    }
+    ScopedTimer outputTimer("output", groups.size());
+    OutputBuffer& out = OutputBuffer::standard();
+
+    if (format != TEXT_FORMAT) {
+        TableEmitter table(out, format, "region", {"region", "records", "cameras", "violations"});
+        for (int32_t group : sortedRegions) {
+            table.field(cameraTable.getRegion(groups.getKey(group)));
+            table.field(groups.getRows(group));
+            table.field(groups.getDistinct(group));
+            table.field(groups.getSum(group));
+            table.endRow();
+        }
+        table.finish();
+        out.flush();
+        return;
+    }
 
-        // Format and display the data
-        cout << left << setw(25) << neigh
-            << right << setw(4) << camCount
-            << right << setw(7) << vioSum << endl;
+    for (int32_t group : sortedRegions) {
+        out.padRight(cameraTable.getRegion(groups.getKey(group)), 25)
+           .padLeft(groups.getRows(group), 8)
+           .padLeft(groups.getDistinct(group), 4)
+           .padLeft(groups.getSum(group), 7) << '\n';
     }
+    out.flush();
 }
 
 /**
  * Generates and displays a bar chart showing violations by month
- * @pre cameraRecords vector is not empty
+ * @param rollup Aggregates of cameraTable, see RollupCube
+ * @param format Console text, TSV, CSV or JSON
+ * @pre cameraTable is not empty
  * @post Displays a bar chart with months and asterisk bars representing violations
  */
-void displayChartByMonth(const vector<CameraRecord>& cameraRecords){
+void displayChartByMonth(const CameraTable& cameraTable, const RollupCube& rollup, OutputFormat format){
     /*
     CASE 3
     */
-   
-    // Vector to store monthly violation data
-    vector<tuple<int, string, int>> violationsPerMonth; // Vector to store (monthNumber, monthName, totalViolations)
 
-    // Process each record to aggregate violations by month
-    for (int i = 0; i < cameraRecords.size(); i++) { // Looping through all records 
-        CameraRecord record = cameraRecords.at(i);
-        string date = record.getDate();
-        
-        // Extract month from date string (YYYY-MM-DD format)
-        int firstHyphen = date.find('-', 4);  // Position of the first hyphen
-        int secondHyphen = date.find('-', firstHyphen + 1); // Position of the second hyphen
-        string monthNumber = date.substr(firstHyphen + 1, secondHyphen - firstHyphen - 1);
-        int monthInt = stoi(monthNumber);
-        string monthName = getMonth(monthInt);
-        
-        int numOfViolations = record.getVio();
-
-        // Check if this month already exists in vector
-        bool monthFound = false;
-        for (int i = 0; i < violationsPerMonth.size(); i++){
-            if (get<0>(violationsPerMonth[i]) == monthInt) {
-                get<2>(violationsPerMonth[i]) += numOfViolations; // Add violations to existing month
-                monthFound = true;
-                break;
+    ScopedTimer timer("report month", cameraTable.size());
+    // Month totals are the neighborhood x month cells of the rollup added together
+    MonthTotals months;
+    {
+        ScopedTimer aggregateTimer("aggregate");
+        months = rollup.monthTotals();
+    }
+    printMonthChart(months, format);
+}
+
+/**
+ * Displays month totals as a bar chart, one star per 1000 violations
+ * @param months Totals to display
+ * @param format Console text, or TSV, CSV or JSON (month number, name and total instead of a bar)
+ */
+void printMonthChart(const MonthTotals& months, OutputFormat format) {
+    ScopedTimer timer("output");
+    OutputBuffer& out = OutputBuffer::standard();
+    if (format != TEXT_FORMAT) {
+        TableEmitter table(out, format, "month", {"month", "name", "violations"});
+        for (int monthInt = 1; monthInt <= 12; monthInt++) {
+            if (months.hasMonth(monthInt)) {
+                table.field(monthInt);
+                table.field(getMonth(monthInt));
+                table.field(months.getViolations(monthInt));
+                table.endRow();
             }
         }
-        // If month wasn't found, add it as a new entry
-        if (!monthFound){
-            violationsPerMonth.push_back(make_tuple(monthInt, monthName, numOfViolations));
-        }   
+        table.finish();
+        out.flush();
+        return;
     }
-    
-    // Sort by month number
-    sort(violationsPerMonth.begin(), violationsPerMonth.end());
-    
-    // Display the bar chart
-    for (int i = 0; i < violationsPerMonth.size(); i++ ) {
-        cout << left << setw(15) << get<1>(violationsPerMonth[i])
-             << left << setw(10) << string(get<2>(violationsPerMonth[i])/1000, '*') << endl;
+
+    // Display the bar chart in month order, the bar padded to 10 characters
+    for (int monthInt = 1; monthInt <= 12; monthInt++) {
+        if (months.hasMonth(monthInt)) {
+            size_t stars = months.getViolations(monthInt) / 1000;
+            out.padRight(getMonth(monthInt), 15).repeat('*', stars).repeat(' ', stars < 10 ? 10 - stars : 0) << '\n';
+        }
+    }
+    out.flush();
+}
+
+/**
+ * Picks the largest totals without sorting every key: nth_element moves the k
+ * largest to the front and only those k are sorted
+ * @param totals Total of each key id; keys with a total of 0 are left out
+ * @param k Number of entries wanted
+ * @return up to k (key id, total) pairs, largest first, ties in key id order
+ */
+vector<pair<int32_t, int64_t>> topTotals(const vector<int64_t>& totals, size_t k) {
+    vector<pair<int32_t, int64_t>> entries;
+    for (size_t key = 0; key < totals.size(); key++) {
+        if (totals[key] != 0) {
+            entries.push_back(make_pair(key, totals[key]));
+        }
+    }
+    auto larger = [](const pair<int32_t, int64_t>& a, const pair<int32_t, int64_t>& b) {
+        return a.second != b.second ? a.second > b.second : a.first < b.first;
+    };
+    k = min(k, entries.size());
+    nth_element(entries.begin(), entries.begin() + k, entries.end(), larger);
+    entries.resize(k);
+    sort(entries.begin(), entries.end(), larger);
+    return entries;
+}
+
+/**
+ * Totals each camera's violations inside a date range from the rollup's
+ * camera x day cells, finding the range in each camera's days by binary search
+ * @param cameraCount Number of camera ids in the table
+ * @return violations of each camera id between from and to (inclusive)
+ */
+vector<int64_t> cameraTotalsInRange(const RollupCube& rollup, int32_t cameraCount, uint32_t from, uint32_t to) {
+    const vector<uint32_t>& dayDates = rollup.getDayDates();
+    const vector<int64_t>& dayViolations = rollup.getDayViolations();
+    vector<int64_t> totals(cameraCount, 0);
+    for (int32_t camera = 0; camera < cameraCount; camera++) {
+        auto begin = dayDates.begin() + rollup.getDayBegin(camera), end = dayDates.begin() + rollup.getDayEnd(camera);
+        size_t first = lower_bound(begin, end, from) - dayDates.begin();
+        size_t last = upper_bound(begin, end, to) - dayDates.begin();
+        for (size_t d = first; d < last; d++) {
+            totals[camera] += dayViolations[d];
+        }
+    }
+    return totals;
+}
+
+/**
+ * Totals violations by an id column over the rows inside a date range only
+ * @param keys Id column to total by, such as the intersection column
+ * @param keyCount Number of distinct ids in the column
+ * @return violations of each id between from and to (inclusive)
+ */
+vector<int64_t> columnTotalsInRange(const CameraTable& cameraTable, const DateIndex& dateIndex,
+                                    const vector<int32_t>& keys, int32_t keyCount, uint32_t from, uint32_t to) {
+    const vector<int32_t>& violations = cameraTable.getVioColumn();
+    const vector<uint32_t>& rowsByDate = dateIndex.getRowsByDate();
+    pair<size_t, size_t> range = dateIndex.dateRange(from, to);
+    vector<int64_t> totals(keyCount, 0);
+    for (uint64_t i = dateIndex.getDateStart(range.first); i < dateIndex.getDateStart(range.second); i++) {
+        uint32_t row = rowsByDate[i];
+        totals[keys[row]] += violations[row];
+    }
+    return totals;
+}
+
+/**
+ * Finds the days with the most violations (over every camera) inside a date range
+ * A min-heap holds the best k days seen so far, so only k days are ever kept
+ * @return up to k (date, violations) pairs, largest first, earlier days first on ties
+ */
+vector<pair<uint32_t, int64_t>> topDaysInRange(const DateIndex& dateIndex, uint32_t from, uint32_t to, size_t k) {
+    // The heap's top is the weakest kept day: fewest violations, latest date on ties
+    auto weaker = [](const pair<uint32_t, int64_t>& a, const pair<uint32_t, int64_t>& b) {
+        return a.second != b.second ? a.second > b.second : a.first < b.first;
+    };
+    priority_queue<pair<uint32_t, int64_t>, vector<pair<uint32_t, int64_t>>, decltype(weaker)> best(weaker);
+    pair<size_t, size_t> range = dateIndex.dateRange(from, to);
+    for (size_t d = range.first; d < range.second && k > 0; d++) {
+        pair<uint32_t, int64_t> day(dateIndex.getDate(d), dateIndex.getDateViolations(d));
+        if (best.size() < k) {
+            best.push(day);
+        }
+        else if (weaker(day, best.top())) {
+            best.pop();
+            best.push(day);
+        }
+    }
+    vector<pair<uint32_t, int64_t>> days;
+    for (; !best.empty(); best.pop()) {
+        days.push_back(best.top());
+    }
+    reverse(days.begin(), days.end());
+    return days;
+}
+
+/**
+ * Totals violations per calendar month (year and month) inside a date range,
+ * so the same month of different years is never merged
+ * @return (year << 4 | month, violations) pairs in date order
+ */
+vector<pair<uint32_t, int64_t>> yearMonthTotalsInRange(const DateIndex& dateIndex, uint32_t from, uint32_t to) {
+    vector<pair<uint32_t, int64_t>> months;
+    pair<size_t, size_t> range = dateIndex.dateRange(from, to);
+    for (size_t d = range.first; d < range.second; d++) {
+        uint32_t yearMonth = dateYearMonth(dateIndex.getDate(d));
+        if (months.empty() || months.back().first != yearMonth) {
+            months.push_back(make_pair(yearMonth, 0));
+        }
+        months.back().second += dateIndex.getDateViolations(d);
+    }
+    return months;
+}
+
+// Writes a packed date as YYYY-MM-DD
+string isoDate(uint32_t date) {
+    char text[16];
+    snprintf(text, sizeof(text), "%04d-%02d-%02d", dateYear(date), dateMonth(date), dateDay(date));
+    return text;
+}
+
+/**
+ * Displays a top list for the query's date range
+ * @param kind "cameras", "intersections" or "days"
+ * @param query Date range and number of entries
+ * @param format Console text, TSV, CSV or JSON
+ */
+void displayTop(const CameraTable& cameraTable, const RollupCube& rollup, const DateIndex& dateIndex,
+                const string& kind, const DateQuery& query, OutputFormat format) {
+    ScopedTimer timer("report top", cameraTable.size());
+    vector<pair<string, int64_t>> entries; // (name, violations) in rank order
+    {
+        ScopedTimer aggregateTimer("aggregate + top-k");
+        if (kind == "days") {
+            for (const pair<uint32_t, int64_t>& day : topDaysInRange(dateIndex, query.from, query.to, query.limit)) {
+                entries.push_back(make_pair(isoDate(day.first), day.second));
+            }
+        }
+        else if (kind == "cameras") {
+            vector<int64_t> totals = cameraTotalsInRange(rollup, cameraTable.getCamCount(), query.from, query.to);
+            for (const pair<int32_t, int64_t>& camera : topTotals(totals, query.limit)) {
+                entries.push_back(make_pair(string(cameraTable.getCamNum(camera.first)), camera.second));
+            }
+        }
+        else {
+            vector<int64_t> totals = columnTotalsInRange(cameraTable, dateIndex, cameraTable.getInterColumn(),
+                                                         cameraTable.getInterCount(), query.from, query.to);
+            for (const pair<int32_t, int64_t>& inter : topTotals(totals, query.limit)) {
+                entries.push_back(make_pair(string(cameraTable.getInter(inter.first)), inter.second));
+            }
+        }
+    }
+    ScopedTimer outputTimer("output", entries.size());
+    OutputBuffer& out = OutputBuffer::standard();
+
+    if (format != TEXT_FORMAT) {
+        string report = "top-" + kind;
+        const char* column = kind == "days" ? "date" : kind == "cameras" ? "camera" : "intersection";
+        TableEmitter table(out, format, report.c_str(), {"rank", column, "violations"});
+        for (size_t rank = 0; rank < entries.size(); rank++) {
+            table.field(rank + 1);
+            table.field(entries[rank].first);
+            table.field(entries[rank].second);
+            table.endRow();
+        }
+        table.finish();
+        out.flush();
+        return;
+    }
+
+    out << "Top " << entries.size() << " " << kind;
+    if (query.from > 1) {
+        out << " from " << isoDate(query.from);
+    }
+    if (query.to != UINT32_MAX) {
+        out << " to " << isoDate(query.to);
     }
+    out << ":\n";
+    for (size_t rank = 0; rank < entries.size(); rank++) {
+        out.padLeft(rank + 1, 4) << ". ";
+        out.padRight(entries[rank].first, 30).padLeft(entries[rank].second, 8) << '\n';
+    }
+    out.flush();
+}
+
+/**
+ * Displays the violations of every calendar month in the query's date range
+ * @param query Date range
+ * @param format Console text, TSV, CSV or JSON
+ */
+void displayYearMonths(const DateIndex& dateIndex, const DateQuery& query, OutputFormat format) {
+    ScopedTimer timer("report yearmonth");
+    vector<pair<uint32_t, int64_t>> months;
+    {
+        ScopedTimer aggregateTimer("aggregate");
+        months = yearMonthTotalsInRange(dateIndex, query.from, query.to);
+    }
+    ScopedTimer outputTimer("output", months.size());
+    OutputBuffer& out = OutputBuffer::standard();
+    if (format != TEXT_FORMAT) {
+        TableEmitter table(out, format, "yearmonth", {"month", "violations"});
+        char label[16];
+        for (const pair<uint32_t, int64_t>& month : months) {
+            snprintf(label, sizeof(label), "%04u-%02u", month.first >> 4, month.first & 15);
+            table.field(string_view(label));
+            table.field(month.second);
+            table.endRow();
+        }
+        table.finish();
+        out.flush();
+        return;
+    }
+    for (const pair<uint32_t, int64_t>& month : months) {
+        out.zeroPadded(month.first >> 4, 4) << '-';
+        out.zeroPadded(month.first & 15, 2).repeat(' ', 3).padLeft(month.second, 8) << '\n';
+    }
+    out.flush();
 }
 
 /**
@@ -389,10 +5015,11 @@ string getMonth(int monthNumber) {
 
 /**
  * Searches for cameras based on intersection or neighborhood name
- * @pre cameraRecords vector is not empty
+ * @param searchIndex Trigram index built from cameraTable; if it was not built the table is scanned
+ * @pre cameraTable is not empty
  * @post Displays matching camera information or "No cameras found" message
  */
-void searchByCamera(const vector<CameraRecord>& cameraRecords){
+void searchByCamera(const CameraTable& cameraTable, const SearchIndex& searchIndex){
     /*
     CASE 4
     */
@@ -402,39 +5029,504 @@ void searchByCamera(const vector<CameraRecord>& cameraRecords){
     cout << "What should we search for?" << endl; 
     cin.ignore(numeric_limits<streamsize>::max(), '\n');  // Clear any leftover newline
     getline(cin, searchTerm);
+    displaySearchResults(cameraTable, searchIndex, searchTerm, TEXT_FORMAT);
+}
+
+/**
+ * Displays every camera whose intersection or neighborhood contains a term, ignoring case
+ * @param searchIndex Trigram index built from cameraTable; if it was not built the table is scanned
+ * @param searchTerm Term to look for, in any case
+ * @param format Console text, TSV, CSV or JSON
+ * @post Displays matching camera information or "No cameras found" message
+ */
+void displaySearchResults(const CameraTable& cameraTable, const SearchIndex& searchIndex,
+                          string searchTerm, OutputFormat format) {
     // Convert searchTerm to lowercase for case-insensitive comparison
     transform(searchTerm.begin(), searchTerm.end(), searchTerm.begin(), ::tolower);
+
+    ScopedTimer timer("report search", cameraTable.size());
+    // Each match is the first row of a camera whose intersection or neighborhood contains the term
+    vector<size_t> matchRows;
+    {
+        ScopedTimer matchTimer(searchIndex.isBuilt() ? "indexed match" : "scan match");
+        matchRows = searchIndex.isBuilt() ? searchIndex.search(searchTerm) : scanSearch(cameraTable, searchTerm);
+    }
+    ScopedTimer outputTimer("output", matchRows.size());
+    OutputBuffer& out = OutputBuffer::standard();
+
+    if (format != TEXT_FORMAT) {
+        TableEmitter table(out, format, "search", {"camera", "address", "intersection", "neighborhood"}, "term", searchTerm);
+        for (size_t row : matchRows) {
+            table.field(cameraTable.getCamNum(cameraTable.getCamColumn()[row]));
+            table.field(cameraTable.getAdd(cameraTable.getAddColumn()[row]));
+            table.field(cameraTable.getInter(cameraTable.getInterColumn()[row]));
+            table.field(cameraTable.getNeigh(cameraTable.getNeighColumn()[row]));
+            table.endRow();
+        }
+        table.finish();
+        out.flush();
+        return;
+    }
+
+    for (size_t row : matchRows) {
+        // Display camera information, with a blank line between entries
+        out << "Camera: " << cameraTable.getCamNum(cameraTable.getCamColumn()[row]) << '\n';
+        out << "Address: " << cameraTable.getAdd(cameraTable.getAddColumn()[row]) << '\n';
+        out << "Intersection: " << cameraTable.getInter(cameraTable.getInterColumn()[row]) << '\n';
+        out << "Neighborhood: " << cameraTable.getNeigh(cameraTable.getNeighColumn()[row]) << "\n\n";
+    }
     
-    bool found = false;
-    vector<string> uniqueCameras;  // Track unique camera numbers
-    
-    // Look for search term in intersection or neighborhood
-    for (int i = 0; i < cameraRecords.size(); i++) { // Looping through all records 
-        CameraRecord record = cameraRecords.at(i);
-        string intersection = record.getInter();
-        string neighborhood = record.getNeigh();
-        
-        // Convert fields to lowercase for case-insensitive comparison
+    // Display message if no cameras were found
+    if (matchRows.empty()) {
+        out << "No cameras found.\n";
+    }
+    out.flush();
+}
+
+/**
+ * Searches without an index by matching every distinct intersection and
+ * neighborhood in place, then scanning the rows for each matching camera's first row
+ * @param searchTerm Lowercase term to look for
+ * @return the same rows SearchIndex::search() would return
+ */
+vector<size_t> scanSearch(const CameraTable& cameraTable, const string& searchTerm) {
+    // Match the dictionary bytes directly, without making lowercase copies
+    vector<bool> interMatches(cameraTable.getInterCount());
+    for (int32_t id = 0; id < cameraTable.getInterCount(); id++) {
+        interMatches[id] = containsIgnoreCase(cameraTable.getInter(id), searchTerm);
+    }
+    vector<bool> neighMatches(cameraTable.getNeighCount());
+    for (int32_t id = 0; id < cameraTable.getNeighCount(); id++) {
+        neighMatches[id] = containsIgnoreCase(cameraTable.getNeigh(id), searchTerm);
+    }
+
+    vector<size_t> matchRows;
+    vector<bool> seenCameras(cameraTable.getCamCount(), false);  // Track unique camera ids
+    const vector<int32_t>& cameraIds = cameraTable.getCamColumn();
+    const vector<int32_t>& intersectionIds = cameraTable.getInterColumn();
+    const vector<int32_t>& neighborhoodIds = cameraTable.getNeighColumn();
+    for (size_t i = 0; i < cameraIds.size(); i++) {
+        if (!seenCameras[cameraIds[i]] && (interMatches[intersectionIds[i]] || neighMatches[neighborhoodIds[i]])) {
+            seenCameras[cameraIds[i]] = true;
+            matchRows.push_back(i);
+        }
+    }
+    return matchRows;
+}
+
+// Lowercases one ASCII character, the same as tolower() in the "C" locale
+inline char lowerAscii(char c) {
+    return (c >= 'A' && c <= 'Z') ? c + ('a' - 'A') : c;
+}
+
+// Whether text starting at start equals lowerTerm ignoring case
+inline bool equalsIgnoreCase(const char* start, string_view lowerTerm) {
+    for (size_t j = 0; j < lowerTerm.size(); j++) {
+        if (lowerAscii(start[j]) != lowerTerm[j]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+/**
+ * Checks whether text contains a term, ignoring case, one position at a time
+ * @param text Text to search, in any case
+ * @param lowerTerm Term to find, already lowercase
+ * @return true if lowerTerm occurs in text
+ */
+bool containsIgnoreCaseScalar(string_view text, string_view lowerTerm) {
+    if (lowerTerm.size() > text.size()) {
+        return false;
+    }
+    for (size_t i = 0; i + lowerTerm.size() <= text.size(); i++) {
+        if (equalsIgnoreCase(text.data() + i, lowerTerm)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+#if defined(__x86_64__)
+// Lowercases 16 ASCII characters at once: bytes in 'A'..'Z' get the 0x20 bit set
+inline __m128i lowerAscii16(__m128i block) {
+    __m128i upper = _mm_and_si128(_mm_cmpgt_epi8(block, _mm_set1_epi8('A' - 1)),
+                                  _mm_cmplt_epi8(block, _mm_set1_epi8('Z' + 1)));
+    return _mm_or_si128(block, _mm_and_si128(upper, _mm_set1_epi8(0x20)));
+}
+
+/**
+ * SSE2 version of containsIgnoreCaseScalar()
+ * Compares 16 starting positions at a time against the term's first and last
+ * character, and only checks the whole term where both match
+ */
+bool containsIgnoreCaseSse2(string_view text, string_view lowerTerm) {
+    size_t n = lowerTerm.size();
+    if (n == 0 || n > text.size()) {
+        return n == 0;
+    }
+    const __m128i first = _mm_set1_epi8(lowerTerm[0]);
+    const __m128i last = _mm_set1_epi8(lowerTerm[n - 1]);
+    size_t starts = text.size() - n + 1; // Number of positions the term could start at
+    size_t i = 0;
+    for (; i + 16 <= starts; i += 16) {
+        __m128i blockFirst = lowerAscii16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(text.data() + i)));
+        __m128i blockLast = lowerAscii16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(text.data() + i + n - 1)));
+        unsigned mask = _mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(blockFirst, first),
+                                                        _mm_cmpeq_epi8(blockLast, last)));
+        while (mask != 0) {
+            if (equalsIgnoreCase(text.data() + i + __builtin_ctz(mask), lowerTerm)) {
+                return true;
+            }
+            mask &= mask - 1;
+        }
+    }
+    return containsIgnoreCaseScalar(text.substr(i), lowerTerm);
+}
+
+// Lowercases 32 ASCII characters at once
+__attribute__((target("avx2"))) inline __m256i lowerAscii32(__m256i block) {
+    __m256i upper = _mm256_and_si256(_mm256_cmpgt_epi8(block, _mm256_set1_epi8('A' - 1)),
+                                     _mm256_cmpgt_epi8(_mm256_set1_epi8('Z' + 1), block));
+    return _mm256_or_si256(block, _mm256_and_si256(upper, _mm256_set1_epi8(0x20)));
+}
+
+// AVX2 version of containsIgnoreCaseSse2(), 32 starting positions at a time
+__attribute__((target("avx2"))) bool containsIgnoreCaseAvx2(string_view text, string_view lowerTerm) {
+    size_t n = lowerTerm.size();
+    if (n == 0 || n > text.size()) {
+        return n == 0;
+    }
+    const __m256i first = _mm256_set1_epi8(lowerTerm[0]);
+    const __m256i last = _mm256_set1_epi8(lowerTerm[n - 1]);
+    size_t starts = text.size() - n + 1;
+    size_t i = 0;
+    for (; i + 32 <= starts; i += 32) {
+        __m256i blockFirst = lowerAscii32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(text.data() + i)));
+        __m256i blockLast = lowerAscii32(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(text.data() + i + n - 1)));
+        unsigned mask = _mm256_movemask_epi8(_mm256_and_si256(_mm256_cmpeq_epi8(blockFirst, first),
+                                                              _mm256_cmpeq_epi8(blockLast, last)));
+        while (mask != 0) {
+            if (equalsIgnoreCase(text.data() + i + __builtin_ctz(mask), lowerTerm)) {
+                return true;
+            }
+            mask &= mask - 1;
+        }
+    }
+    return containsIgnoreCaseSse2(text.substr(i), lowerTerm);
+}
+#endif
+
+/**
+ * Checks whether text contains a term, ignoring case, using the widest
+ * vector instructions the CPU supports (picked once, on first use)
+ * @param text Text to search, in any case
+ * @param lowerTerm Term to find, already lowercase
+ * @return true if lowerTerm occurs in text
+ */
+bool containsIgnoreCase(string_view text, string_view lowerTerm) {
+    typedef bool (*Matcher)(string_view, string_view);
+    static const Matcher matcher = []() -> Matcher {
+#if defined(__x86_64__)
+        if (__builtin_cpu_supports("avx2")) {
+            return containsIgnoreCaseAvx2;
+        }
+        return containsIgnoreCaseSse2;
+#else
+        return containsIgnoreCaseScalar;
+#endif
+    }();
+    return matcher(text, lowerTerm);
+}
+
+/**
+ * Times one search term over every row of one or more files with the original
+ * transform + find loop, the scalar matcher and the vector matcher
+ * @param searchTerm Term to search for
+ * @param fileNames Files loaded together into one table
+ * @param threads Number of threads used for loading
+ * @post Prints the time and number of matching rows for each method
+ */
+void benchmarkSearch(const string& searchTerm, const vector<string>& fileNames, int threads) {
+    vector<CameraTable> parts;
+    for (const string& fileName : fileNames) {
+        parts.push_back(readFile(fileName, threads, false));
+    }
+    CameraTable cameraTable;
+    cameraTable.append(parts, threads <= 0 ? defaultThreads() : threads);
+
+    string lowerTerm = searchTerm;
+    transform(lowerTerm.begin(), lowerTerm.end(), lowerTerm.begin(), ::tolower);
+    const vector<int32_t>& intersectionIds = cameraTable.getInterColumn();
+    const vector<int32_t>& neighborhoodIds = cameraTable.getNeighColumn();
+    cout << fixed << setprecision(2) << cameraTable.size() << " rows, term \"" << searchTerm << "\"" << endl;
+
+    // Original: copy and lowercase both fields of every row, then find()
+    auto start = chrono::steady_clock::now();
+    size_t matches = 0;
+    for (size_t i = 0; i < cameraTable.size(); i++) {
+        string intersection = string(cameraTable.getInter(intersectionIds[i]));
+        string neighborhood = string(cameraTable.getNeigh(neighborhoodIds[i]));
         transform(intersection.begin(), intersection.end(), intersection.begin(), ::tolower);
         transform(neighborhood.begin(), neighborhood.end(), neighborhood.begin(), ::tolower);
+        matches += intersection.find(lowerTerm) != string::npos || neighborhood.find(lowerTerm) != string::npos;
+    }
+    auto stop = chrono::steady_clock::now();
+    cout << "  transform + find: " << chrono::duration<double, milli>(stop - start).count()
+         << " ms, " << matches << " matching rows" << endl;
 
-        // Only process if we haven't seen this camera before and search term matches
-        if (find(uniqueCameras.begin(), uniqueCameras.end(), record.getCamNum()) == uniqueCameras.end() &&
-            (intersection.find(searchTerm) != string::npos || neighborhood.find(searchTerm) != string::npos)) {
-            
-            found = true;
-            uniqueCameras.push_back(record.getCamNum());  // Mark this camera as seen
-            // Display camera information
-            cout << "Camera: " << record.getCamNum() << endl;
-            cout << "Address: " << record.getAdd() << endl;
-            cout << "Intersection: " << record.getInter() << endl;
-            cout << "Neighborhood: " << record.getNeigh() << endl;
-            cout << endl;  // Add blank line between entries
+    // In-place matchers on the same per-row fields
+    for (int useVector = 0; useVector <= 1; useVector++) {
+        start = chrono::steady_clock::now();
+        matches = 0;
+        for (size_t i = 0; i < cameraTable.size(); i++) {
+            string_view intersection = cameraTable.getInter(intersectionIds[i]);
+            string_view neighborhood = cameraTable.getNeigh(neighborhoodIds[i]);
+            if (useVector) {
+                matches += containsIgnoreCase(intersection, lowerTerm) || containsIgnoreCase(neighborhood, lowerTerm);
+            }
+            else {
+                matches += containsIgnoreCaseScalar(intersection, lowerTerm) || containsIgnoreCaseScalar(neighborhood, lowerTerm);
+            }
         }
+        stop = chrono::steady_clock::now();
+        cout << (useVector ? "  vector matcher:   " : "  scalar matcher:   ")
+             << chrono::duration<double, milli>(stop - start).count() << " ms, " << matches << " matching rows" << endl;
     }
-    
-    // Display message if no cameras were found
-    if (!found) {
-        cout << "No cameras found." << endl;
+}
+
+/**
+ * Writes a synthetic data file that follows the distributions of real data files
+ * Each row copies a random row of the seed files, so cameras, neighborhoods and
+ * dates keep their real mix and pairing; the violation count is drawn from a
+ * Poisson distribution around the copied value
+ * Past the size of the seed data the rows are spread over earlier years (up to
+ * 10) and then over cloned cameras, so large files keep a realistic number of
+ * rows per camera and day
+ * @param rows Number of rows to write
+ * @param outName File to create
+ * @param seedFiles Real data files to copy rows from
+ * @param seed Random seed, so the same arguments always give the same file
+ * @param threads Number of threads for loading the seed files
+ * @return true if the file was written
+ */
+bool generateData(size_t rows, const string& outName, const vector<string>& seedFiles, uint64_t seed, int threads) {
+    CameraTable seedTable = readFiles(seedFiles, threads, false);
+    if (seedTable.size() == 0) {
+        cerr << "No seed rows to generate from." << endl;
+        return false;
+    }
+    FILE* fileOut = fopen(outName.c_str(), "wb");
+    if (fileOut == nullptr) {
+        cerr << "Unable to create file: " << outName << endl;
+        return false;
+    }
+
+    const vector<int32_t>& intersectionIds = seedTable.getInterColumn();
+    const vector<int32_t>& addressIds = seedTable.getAddColumn();
+    const vector<int32_t>& cameraIds = seedTable.getCamColumn();
+    const vector<uint32_t>& dates = seedTable.getDateColumn();
+    const vector<int32_t>& violations = seedTable.getVioColumn();
+    const vector<int32_t>& neighborhoodIds = seedTable.getNeighColumn();
+    size_t seedRows = seedTable.size();
+
+    mt19937_64 random(seed);
+    uniform_int_distribution<size_t> pickRow(0, seedRows - 1);
+    string buffer;
+    buffer.reserve(1 << 20);
+    // Text with commas, quotes or line breaks is quoted, with quotes doubled, as the CSV TableEmitter does
+    auto appendField = [&buffer](string_view text) {
+        if (text.find_first_of(",\"\r\n") == string_view::npos) {
+            buffer.append(text);
+            return;
+        }
+        buffer += '"';
+        for (char c : text) {
+            buffer.append(c == '"' ? 2 : 1, c);
+        }
+        buffer += '"';
+    };
+    for (size_t i = 0; i < rows; i++) {
+        size_t row = pickRow(random);
+        size_t copy = i / seedRows;  // Which pass over the seed data this row belongs to
+        int yearsBack = copy % 10;
+        size_t cameraClone = copy / 10;
+
+        // Cloned cameras get their own number so they count as separate cameras
+        string_view camera = seedTable.getCamNum(cameraIds[row]);
+        string cameraText(camera);
+        if (cameraClone > 0) {
+            uint64_t number = 0;
+            bool numeric = !camera.empty() && camera.size() < 10;
+            for (char c : camera) {
+                numeric = numeric && c >= '0' && c <= '9';
+                number = number * 10 + (c - '0');
+            }
+            cameraText = numeric ? to_string(number + cameraClone * 100000) : cameraText + "-" + to_string(cameraClone);
+        }
+
+        // Same month and day in an earlier year; February 29 becomes the 28th outside leap years
+        uint32_t date = dates[row];
+        int year = dateYear(date) - yearsBack, month = dateMonth(date), day = dateDay(date);
+        if (month == 2 && day == 29 && !(year % 4 == 0 && (year % 100 != 0 || year % 400 == 0))) {
+            day = 28;
+        }
+
+        int count = violations[row];
+        if (count > 0) {
+            poisson_distribution<int> around(count);
+            count = around(random);
+        }
+
+        char numbers[64];
+        snprintf(numbers, sizeof(numbers), ",%d-%d-%d,%d,", year, month, day, count);
+        appendField(seedTable.getInter(intersectionIds[row]));
+        buffer += ',';
+        appendField(seedTable.getAdd(addressIds[row]));
+        buffer += ',';
+        appendField(cameraText);
+        buffer.append(numbers);
+        appendField(seedTable.getNeigh(neighborhoodIds[row]));
+        buffer += '\n';
+        if (buffer.size() >= (1 << 20) - 512) {
+            fwrite(buffer.data(), 1, buffer.size(), fileOut);
+            buffer.clear();
+        }
+    }
+    fwrite(buffer.data(), 1, buffer.size(), fileOut);
+    bool written = !ferror(fileOut);
+    written = fclose(fileOut) == 0 && written;
+    return written;
+}
+
+/**
+ * Runs a task several times and keeps the fastest run
+ * @param repeats Number of runs
+ * @param task Function to time
+ * @return the fastest time in milliseconds
+ */
+template <typename Task>
+double fastestMs(int repeats, const Task& task) {
+    double best = numeric_limits<double>::max();
+    for (int r = 0; r < repeats; r++) {
+        auto start = chrono::steady_clock::now();
+        task();
+        auto stop = chrono::steady_clock::now();
+        best = min(best, chrono::duration<double, milli>(stop - start).count());
+    }
+    return best;
+}
+
+/**
+ * Benchmarks every part of the program on generated data files and writes
+ * the results to cout as one JSON object, so runs can be stored and compared
+ * For each size: generation, ingest, rollup build, snapshot save (the write alone) and load, the
+ * overview, neighborhood and month reports (scanning the rows and from the rollup)
+ * and search (index build, indexed search and full scan)
+ * Progress is written to cerr
+ * @param rowCounts Sizes of the generated data files
+ * @param seedFiles Real data files the generator copies from
+ * @param threads Number of threads, 0 uses every hardware thread
+ * @param repeats Runs per measurement; the fastest run is reported
+ */
+void benchmarkSuite(const vector<size_t>& rowCounts, const vector<string>& seedFiles, int threads, int repeats) {
+    if (threads <= 0) {
+        threads = defaultThreads();
+    }
+    string dataName = "/tmp/camera-suite-" + to_string(getpid()) + ".txt";
+    const string searchTerm = "lake";
+
+    cout << "{\n  \"threads\": " << threads << ",\n  \"repeats\": " << repeats << ",\n  \"results\": [";
+    bool firstResult = true;
+    // Adds one result; result is a count from the measured work, to check runs against each other
+    auto report = [&](const string& name, size_t rows, uint64_t bytes, double ms, uint64_t result) {
+        cout << (firstResult ? "\n" : ",\n") << fixed << setprecision(3)
+             << "    {\"name\": \"" << name << "\", \"rows\": " << rows << ", \"bytes\": " << bytes
+             << ", \"ms\": " << ms << ", \"rows_per_s\": " << setprecision(0) << rows / max(ms, 1e-6) * 1000
+             << ", \"result\": " << result << "}";
+        firstResult = false;
+        cerr << fixed << name << " (" << rows << " rows): " << setprecision(3) << ms << " ms" << endl;
+    };
+
+    for (size_t rows : rowCounts) {
+        // Generate once; the time is reported but not repeated
+        double ms = fastestMs(1, [&]() { generateData(rows, dataName, seedFiles, 42, threads); });
+        struct stat info;
+        uint64_t bytes = stat(dataName.c_str(), &info) == 0 ? info.st_size : 0;
+        report("generate", rows, bytes, ms, bytes);
+
+        CameraTable cameraTable;
+        ms = fastestMs(repeats, [&]() { cameraTable = readFile(dataName, threads, false); });
+        report("ingest", rows, bytes, ms, cameraTable.size());
+
+        RollupCube rollup;
+        ms = fastestMs(repeats, [&]() { rollup.build(cameraTable, threads); });
+        report("rollup_build", rows, 0, ms, rollup.getOverview().getRecords());
+
+        // Only writing the snapshot of the parsed table and cube is timed, the same steps readFile() takes
+        string snapshotName = dataName + ".snap";
+        ms = fastestMs(repeats, [&]() {
+            SnapshotWriter writer;
+            if (writer.open(snapshotName, info)) {
+                cameraTable.save(writer);
+                rollup.save(writer);
+                writer.finish();
+            }
+        });
+        report("snapshot_save", rows, bytes, ms, cameraTable.size());
+        ms = fastestMs(repeats, [&]() { cameraTable = readFile(dataName, threads, true); });
+        report("snapshot_load", rows, bytes, ms, cameraTable.size());
+        remove(snapshotName.c_str());
+
+        // Overview: the fused parallel scan, then the rollup lookup
+        OverviewStats stats;
+        ms = fastestMs(repeats, [&]() {
+            size_t ranges = scanRanges(rows, threads);
+            vector<OverviewStats> partials(ranges);
+            parallelFor(ranges, threads, [&](size_t r) {
+                partials[r].scan(cameraTable, cameraTable.size() * r / ranges, cameraTable.size() * (r + 1) / ranges);
+            });
+            stats = OverviewStats();
+            for (const OverviewStats& partial : partials) {
+                stats.merge(partial);
+            }
+        });
+        report("overview_scan", rows, 0, ms, stats.getTotalViolations());
+        ms = fastestMs(repeats, [&]() { stats = rollup.getOverview(); });
+        report("overview_rollup", rows, 0, ms, stats.getTotalViolations());
+
+        // Neighborhoods: grouping and sorting, from the rows and from the rollup
+        vector<int32_t> order;
+        ms = fastestMs(repeats, [&]() {
+            order = sortByViolations(groupByColumn(cameraTable, cameraTable.getNeighColumn(), threads));
+        });
+        report("neighborhood_scan", rows, 0, ms, order.size());
+        ms = fastestMs(repeats, [&]() { order = sortByViolations(rollup.neighborhoodGroups()); });
+        report("neighborhood_rollup", rows, 0, ms, order.size());
+
+        // Month chart totals, from the rows and from the rollup
+        MonthTotals months;
+        ms = fastestMs(repeats, [&]() {
+            months = MonthTotals();
+            months.scan(cameraTable, 0, cameraTable.size());
+        });
+        report("month_scan", rows, 0, ms, months.getViolations(1));
+        ms = fastestMs(repeats, [&]() { months = rollup.monthTotals(); });
+        report("month_rollup", rows, 0, ms, months.getViolations(1));
+
+        // Search: building the trigram index, an indexed search and a full scan
+        SearchIndex searchIndex;
+        ms = fastestMs(repeats, [&]() {
+            searchIndex = SearchIndex();
+            searchIndex.build(cameraTable);
+        });
+        report("search_index_build", rows, 0, ms, cameraTable.getInterCount());
+        vector<size_t> matches;
+        ms = fastestMs(repeats, [&]() { matches = searchIndex.search(searchTerm); });
+        report("search_indexed", rows, 0, ms, matches.size());
+        ms = fastestMs(repeats, [&]() { matches = scanSearch(cameraTable, searchTerm); });
+        report("search_scan", rows, 0, ms, matches.size());
     }
+    remove(dataName.c_str());
+    cout << "\n  ]\n}" << endl;
 }